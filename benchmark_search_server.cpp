@@ -0,0 +1,1116 @@
+#include "benchmark_search_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <set>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "compressed_search_server.h"
+#include "concurrent_request_queue.h"
+#include "log_duration.h"
+#include "mapped_search_server.h"
+#include "posting_list.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "request_queue.h"
+#include "search_server.h"
+#include "segmented_search_server.h"
+#include "string_arena.h"
+#include "string_processing.h"
+
+using namespace std::literals;
+
+namespace {
+
+constexpr int kDictionarySize = 2'000;
+constexpr int kMaxWordLength = 10;
+constexpr int kDocumentCount = 20'000;
+constexpr int kWordsInDocument = 70;
+constexpr int kQueryCount = 200;
+constexpr int kWordsInQuery = 7;
+
+std::string GenerateWord(std::mt19937& generator, int max_length) {
+    const int length = std::uniform_int_distribution(1, max_length)(generator);
+
+    std::string word;
+    word.reserve(length);
+
+    for (int i = 0; i < length; ++i) {
+        word.push_back(std::uniform_int_distribution('a', 'z')(generator));
+    }
+
+    return word;
+}
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length) {
+    std::vector<std::string> words;
+    words.reserve(word_count);
+
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    return words;
+}
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count,
+                          double minus_probability = 0) {
+    std::string query;
+
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+
+        if (std::uniform_real_distribution<>(0, 1)(generator) < minus_probability) {
+            query.push_back('-');
+        }
+
+        query += dictionary[std::uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+
+    return query;
+}
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                         int query_count, int max_word_count) {
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+
+    return queries;
+}
+
+// Text of words drawn with Zipf frequencies: the word of rank r comes up with probability proportional to 1 / r
+std::string GenerateZipfText(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                             std::discrete_distribution<size_t>& rank_distribution, int word_count) {
+    std::string text;
+
+    for (int i = 0; i < word_count; ++i) {
+        if (!text.empty()) {
+            text.push_back(' ');
+        }
+
+        text += dictionary[rank_distribution(generator)];
+    }
+
+    return text;
+}
+
+std::discrete_distribution<size_t> MakeZipfDistribution(size_t word_count) {
+    std::vector<double> weights(word_count);
+
+    for (size_t rank = 0; rank < word_count; ++rank) {
+        weights[rank] = 1.0 / static_cast<double>(rank + 1);
+    }
+
+    return std::discrete_distribution<size_t>(weights.begin(), weights.end());
+}
+
+SearchServer GenerateSearchServer(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                  int document_count, int words_in_document) {
+    SearchServer search_server(dictionary[0]);
+
+    for (int i = 0; i < document_count; ++i) {
+        search_server.AddDocument(i, GenerateQuery(generator, dictionary, words_in_document), DocumentStatus::ACTUAL,
+                                  {1, 2, 3});
+    }
+
+    return search_server;
+}
+
+// compares scanning the same postings stored in a tree of nodes and in contiguous arrays
+void BenchmarkPostingListScan() {
+    constexpr int kWordCount = 200;
+    constexpr int kPostingsPerWord = 50'000;
+    constexpr int kScanCount = 20;
+
+    std::mt19937 generator;
+
+    std::vector<std::map<int, double>> tree_postings(kWordCount);
+    std::vector<search_server_storage_container::PostingList> array_postings(kWordCount);
+
+    for (int word = 0; word < kWordCount; ++word) {
+        for (int document_id = 0; document_id < kPostingsPerWord * 2; document_id += 2) {
+            const double term_frequency = std::uniform_real_distribution<>(0, 1)(generator);
+            tree_postings[word][document_id] = term_frequency;
+            array_postings[word].Add(document_id, term_frequency);
+        }
+    }
+
+    std::cout << "Posting list scan, "s << kWordCount * kPostingsPerWord << " postings x "s << kScanCount
+              << " scans"s << std::endl;
+
+    double tree_sum = 0;
+    {
+        LOG_DURATION_STREAM("  std::map<int, double>"s, std::cout);
+
+        for (int scan = 0; scan < kScanCount; ++scan) {
+            for (const auto& postings : tree_postings) {
+                for (const auto& [document_id, term_frequency] : postings) {
+                    tree_sum += term_frequency * document_id;
+                }
+            }
+        }
+    }
+
+    double array_sum = 0;
+    {
+        LOG_DURATION_STREAM("  PostingList"s, std::cout);
+
+        for (int scan = 0; scan < kScanCount; ++scan) {
+            for (const auto& postings : array_postings) {
+                const auto& document_ids = postings.GetDocumentIds();
+                const auto& term_frequencies = postings.GetTermFrequencies();
+
+                for (size_t i = 0; i < document_ids.size(); ++i) {
+                    array_sum += term_frequencies[i] * document_ids[i];
+                }
+            }
+        }
+    }
+
+    // keeps both loops from being optimized away
+    std::cout << "  checksums: "s << tree_sum << " / "s << array_sum << std::endl;
+}
+
+void BenchmarkFindTopDocuments() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize, kMaxWordLength);
+    const auto search_server = GenerateSearchServer(generator, dictionary, kDocumentCount, kWordsInDocument);
+    const auto queries = GenerateQueries(generator, dictionary, kQueryCount, kWordsInQuery);
+
+    std::cout << "FindTopDocuments, "s << kDocumentCount << " documents x "s << kQueryCount << " queries"s
+              << std::endl;
+
+    {
+        LOG_DURATION_STREAM("  seq"s, std::cout);
+
+        for (const std::string& query : queries) {
+            search_server.FindTopDocuments(std::execution::seq, query, DocumentStatus::ACTUAL);
+        }
+    }
+
+    {
+        LOG_DURATION_STREAM("  par"s, std::cout);
+
+        for (const std::string& query : queries) {
+            search_server.FindTopDocuments(std::execution::par, query, DocumentStatus::ACTUAL);
+        }
+    }
+}
+
+// joins the results of many cheap queries by reducing vectors by value, by a flat buffer and by a view
+void BenchmarkProcessQueriesJoined() {
+    constexpr int kJoinedDocumentCount = 2'000;
+    constexpr int kJoinedQueryCount = 20'000;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize, kMaxWordLength);
+    const auto search_server = GenerateSearchServer(generator, dictionary, kJoinedDocumentCount, kWordsInDocument);
+    const auto queries = GenerateQueries(generator, dictionary, kJoinedQueryCount, 3);
+
+    std::cout << "Joined results of "s << kJoinedQueryCount << " queries"s << std::endl;
+
+    size_t reduced_count = 0;
+    {
+        LOG_DURATION_STREAM("  reduce of vectors"s, std::cout);
+
+        const auto results = ProcessQueries(search_server, queries);
+        const auto join = [](std::vector<Document> first, std::vector<Document> second) {
+            first.insert(first.end(), second.begin(), second.end());
+            return first;
+        };
+
+        reduced_count =
+            std::reduce(std::execution::par, results.begin(), results.end(), std::vector<Document>{}, join).size();
+    }
+
+    size_t flattened_count = 0;
+    {
+        LOG_DURATION_STREAM("  flat buffer"s, std::cout);
+        flattened_count = ProcessQueriesJoined(search_server, queries).size();
+    }
+
+    size_t viewed_count = 0;
+    {
+        LOG_DURATION_STREAM("  joined view"s, std::cout);
+
+        const auto results = ProcessQueries(search_server, queries);
+        for ([[maybe_unused]] const Document& document : JoinedDocumentsView(results)) {
+            ++viewed_count;
+        }
+    }
+
+    std::cout << "  documents: "s << reduced_count << " / "s << flattened_count << " / "s << viewed_count
+              << std::endl;
+}
+
+// serves a skewed stream of queries, drawn from a pool with Zipf frequencies, with and without the result cache
+void BenchmarkResultCache() {
+    constexpr int kQueryPoolSize = 2'000;
+    constexpr int kQueryStreamLength = 20'000;
+    constexpr size_t kCacheCapacity = 256;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize, kMaxWordLength);
+    auto search_server = GenerateSearchServer(generator, dictionary, kDocumentCount, kWordsInDocument);
+    const auto query_pool = GenerateQueries(generator, dictionary, kQueryPoolSize, kWordsInQuery);
+
+    auto rank_distribution = MakeZipfDistribution(query_pool.size());
+    std::vector<const std::string*> queries;
+    queries.reserve(kQueryStreamLength);
+    for (int i = 0; i < kQueryStreamLength; ++i) {
+        queries.push_back(&query_pool[rank_distribution(generator)]);
+    }
+
+    std::cout << "Result cache, "s << kQueryStreamLength << " queries drawn from "s << kQueryPoolSize << std::endl;
+
+    for (const size_t capacity : {size_t{0}, kCacheCapacity}) {
+        search_server.SetResultCacheCapacity(capacity);
+
+        {
+            LOG_DURATION_STREAM("  capacity "s + std::to_string(capacity) + ", one thread"s, std::cout);
+            for (const std::string* query : queries) {
+                search_server.FindTopDocuments(*query);
+            }
+        }
+
+        {
+            LOG_DURATION_STREAM("  capacity "s + std::to_string(capacity) + ", concurrent queries"s, std::cout);
+            std::for_each(std::execution::par, queries.begin(), queries.end(),
+                          [&search_server](const std::string* query) { search_server.FindTopDocuments(*query); });
+        }
+
+        const auto statistics = search_server.GetResultCacheStatistics();
+        std::cout << "  hits: "s << statistics.hit_count << ", misses: "s << statistics.miss_count << std::endl;
+    }
+}
+
+// many threads adding requests to a RequestQueue behind a mutex and to a ConcurrentRequestQueue
+void BenchmarkRequestQueues() {
+    constexpr int kQueueDocumentCount = 1'000;
+    constexpr int kRequestCount = 100'000;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize, kMaxWordLength);
+    const auto search_server = GenerateSearchServer(generator, dictionary, kQueueDocumentCount, 10);
+    const auto queries = GenerateQueries(generator, dictionary, kRequestCount, 2);
+
+    std::cout << "Request queues, "s << kRequestCount << " concurrent requests"s << std::endl;
+
+    {
+        RequestQueue request_queue(search_server);
+        std::mutex request_queue_mutex;
+
+        LOG_DURATION_STREAM("  RequestQueue and a mutex"s, std::cout);
+        std::for_each(std::execution::par, queries.begin(), queries.end(), [&](const std::string& query) {
+            std::lock_guard guard(request_queue_mutex);
+            request_queue.AddFindRequest(query);
+        });
+    }
+
+    ConcurrentRequestQueue request_queue(search_server);
+    {
+        LOG_DURATION_STREAM("  ConcurrentRequestQueue"s, std::cout);
+        std::for_each(std::execution::par, queries.begin(), queries.end(),
+                      [&request_queue](const std::string& query) { request_queue.AddFindRequest(query); });
+    }
+
+    std::cout << "  requests without results: "s << request_queue.GetNoResultRequests() << std::endl;
+}
+
+// parallel scoring with the shard count, and so the number of busy threads, growing from 1 to hardware threads
+void BenchmarkParallelScoringScaling() {
+    constexpr int kLargeDocumentCount = 100'000;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize, kMaxWordLength);
+    auto search_server = GenerateSearchServer(generator, dictionary, kLargeDocumentCount, kWordsInDocument);
+    const auto queries = GenerateQueries(generator, dictionary, kQueryCount, kWordsInQuery);
+
+    const int max_thread_count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::cout << "Parallel scoring scaling, "s << kLargeDocumentCount << " documents x "s << kQueryCount
+              << " queries"s << std::endl;
+
+    for (int thread_count = 1; thread_count <= max_thread_count; thread_count *= 2) {
+        search_server.SetParallelScoringShardCount(thread_count);
+
+        LOG_DURATION_STREAM("  "s + std::to_string(thread_count) + " thread(s)"s, std::cout);
+
+        for (const std::string& query : queries) {
+            search_server.FindTopDocuments(std::execution::par, query, DocumentStatus::ACTUAL);
+        }
+    }
+}
+
+// matching one query against every document, parsing it per document or once
+void BenchmarkMatchDocuments() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize, kMaxWordLength);
+    const auto search_server = GenerateSearchServer(generator, dictionary, kDocumentCount, kWordsInDocument);
+    const auto query = GenerateQuery(generator, dictionary, kWordsInQuery, 0.1);
+
+    std::cout << "MatchDocument over "s << kDocumentCount << " documents"s << std::endl;
+
+    size_t matched_word_count = 0;
+    {
+        LOG_DURATION_STREAM("  raw query"s, std::cout);
+
+        for (const int document_id : search_server) {
+            matched_word_count += std::get<0>(search_server.MatchDocument(query, document_id)).size();
+        }
+    }
+
+    {
+        LOG_DURATION_STREAM("  prepared query"s, std::cout);
+
+        const auto prepared_query = search_server.PrepareQuery(query);
+
+        for (const int document_id : search_server) {
+            matched_word_count -= std::get<0>(search_server.MatchDocument(prepared_query, document_id)).size();
+        }
+    }
+
+    {
+        LOG_DURATION_STREAM("  batch, seq"s, std::cout);
+
+        const auto table = search_server.MatchDocuments(search_server.PrepareQuery(query), 0, kDocumentCount);
+
+        for (size_t row = 0; row < table.GetDocumentCount(); ++row) {
+            matched_word_count += table.GetMatchedWords(row).size();
+        }
+    }
+
+    {
+        LOG_DURATION_STREAM("  batch, par"s, std::cout);
+
+        const auto table =
+            search_server.MatchDocuments(std::execution::par, search_server.PrepareQuery(query), 0, kDocumentCount);
+
+        for (size_t row = 0; row < table.GetDocumentCount(); ++row) {
+            matched_word_count -= table.GetMatchedWords(row).size();
+        }
+    }
+
+    std::cout << "  mismatched words: "s << matched_word_count << std::endl;
+}
+
+// splitting plus validation as AddDocument did them before, against the single vectorized pass
+void BenchmarkTokenizer() {
+    constexpr size_t kTextSize = 64 * 1024 * 1024;
+    constexpr int kRepeatCount = 5;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize, kMaxWordLength);
+
+    std::string text;
+    text.reserve(kTextSize + kMaxWordLength + 1);
+    while (text.size() < kTextSize) {
+        text += GenerateQuery(generator, dictionary, 1000);
+        text.push_back(' ');
+    }
+
+    std::cout << "Tokenizer, "s << text.size() / (1024 * 1024) << " MiB x "s << kRepeatCount << std::endl;
+
+    const auto report = [&text](const std::string& name, auto tokenize) {
+        size_t word_count = 0;
+
+        const auto start_time = std::chrono::steady_clock::now();
+        for (int repeat = 0; repeat < kRepeatCount; ++repeat) {
+            word_count += tokenize(text);
+        }
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start_time;
+
+        const double gigabytes = static_cast<double>(text.size()) * kRepeatCount / 1e9;
+        std::cout << "  "s << name << ": "s << gigabytes / duration.count() << " GB/s ("s << word_count << " words)"s
+                  << std::endl;
+    };
+
+    report("find + none_of"s, [](std::string_view text) {
+        const bool is_valid = std::none_of(text.begin(), text.end(), [](char c) { return c >= '\0' && c < ' '; });
+        return is_valid ? string_processing::SplitIntoWords(text).size() : 0;
+    });
+
+    std::vector<std::string_view> words;
+    report("SplitIntoWordsValidated"s, [&words](std::string_view text) {
+        return string_processing::SplitIntoWordsValidated(text, words) ? words.size() : 0;
+    });
+}
+
+// indexing the same corpus document by document and in one batch
+void BenchmarkAddDocuments() {
+    constexpr int kIngestDocumentCount = 100'000;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize * 10, kMaxWordLength);
+
+    std::vector<std::string> texts;
+    texts.reserve(kIngestDocumentCount);
+    for (int i = 0; i < kIngestDocumentCount; ++i) {
+        texts.push_back(GenerateQuery(generator, dictionary, kWordsInDocument));
+    }
+
+    std::vector<SearchServer::NewDocument> documents;
+    documents.reserve(kIngestDocumentCount);
+    for (int i = 0; i < kIngestDocumentCount; ++i) {
+        documents.push_back({i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+
+    std::cout << "Indexing "s << kIngestDocumentCount << " documents"s << std::endl;
+
+    const auto report = [](const std::string& name, auto add_documents) {
+        SearchServer search_server("and with"s);
+
+        const auto start_time = std::chrono::steady_clock::now();
+        add_documents(search_server);
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start_time;
+
+        std::cout << "  "s << name << ": "s << static_cast<int>(search_server.GetDocumentCount() / duration.count())
+                  << " docs/sec"s << std::endl;
+    };
+
+    report("AddDocument loop"s, [&documents](SearchServer& search_server) {
+        for (const auto& document : documents) {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+    });
+
+    report("AddDocuments, seq"s, [&documents](SearchServer& search_server) { search_server.AddDocuments(documents); });
+
+    report("AddDocuments, par"s, [&documents](SearchServer& search_server) {
+        search_server.AddDocuments(std::execution::par, documents);
+    });
+}
+
+// removing a quarter of the documents with postings purged at once, by amortized compaction and never
+void BenchmarkRemoveDocuments() {
+    constexpr int kRemovedDocumentCount = kDocumentCount / 4;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize, kMaxWordLength);
+    const auto queries = GenerateQueries(generator, dictionary, kQueryCount, kWordsInQuery);
+
+    std::vector<std::string> texts;
+    texts.reserve(kDocumentCount);
+    for (int i = 0; i < kDocumentCount; ++i) {
+        texts.push_back(GenerateQuery(generator, dictionary, kWordsInDocument));
+    }
+
+    std::vector<SearchServer::NewDocument> documents;
+    documents.reserve(kDocumentCount);
+    for (int i = 0; i < kDocumentCount; ++i) {
+        documents.push_back({i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+
+    std::vector<int> removed_document_ids(kDocumentCount);
+    std::iota(removed_document_ids.begin(), removed_document_ids.end(), 0);
+    std::shuffle(removed_document_ids.begin(), removed_document_ids.end(), generator);
+    removed_document_ids.resize(kRemovedDocumentCount);
+
+    std::cout << "Removing "s << kRemovedDocumentCount << " of "s << kDocumentCount << " documents"s << std::endl;
+
+    for (const auto& [name, compaction_threshold] :
+         {std::pair{"purged at once"s, 0.0}, std::pair{"compacted at default threshold"s,
+                                                       SearchServer::kDefaultCompactionThreshold},
+          std::pair{"never compacted"s, 1.0}}) {
+        SearchServer search_server;
+        search_server.AddDocuments(documents);
+        search_server.SetCompactionThreshold(compaction_threshold);
+
+        {
+            LOG_DURATION_STREAM("  "s + name + ", removals"s, std::cout);
+            for (const int document_id : removed_document_ids) {
+                search_server.RemoveDocument(document_id);
+            }
+        }
+
+        LOG_DURATION_STREAM("  "s + name + ", "s + std::to_string(kQueryCount) + " queries"s, std::cout);
+        for (const std::string& query : queries) {
+            search_server.FindTopDocuments(query);
+        }
+    }
+}
+
+// finds the duplicates of many documents as sets of word copies in a tree and as fingerprints in a hash table
+void BenchmarkRemoveDuplicates() {
+    constexpr int kDuplicateDocumentCount = 100'000;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize, kMaxWordLength);
+
+    std::vector<std::string> texts;
+    texts.reserve(kDuplicateDocumentCount);
+    for (int i = 0; i < kDuplicateDocumentCount; ++i) {
+        // every fourth document repeats the words of an earlier one
+        if (i % 4 == 3) {
+            texts.push_back(texts[std::uniform_int_distribution(0, i - 1)(generator)]);
+        } else {
+            texts.push_back(GenerateQuery(generator, dictionary, kWordsInDocument));
+        }
+    }
+
+    std::vector<SearchServer::NewDocument> documents;
+    documents.reserve(kDuplicateDocumentCount);
+    for (int i = 0; i < kDuplicateDocumentCount; ++i) {
+        documents.push_back({i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+
+    SearchServer search_server;
+    search_server.AddDocuments(documents);
+
+    std::cout << "Finding duplicates of "s << kDuplicateDocumentCount << " documents"s << std::endl;
+
+    size_t word_set_duplicate_count = 0;
+    {
+        LOG_DURATION_STREAM("  sets of words"s, std::cout);
+
+        std::set<std::set<std::string>> unique_documents;
+        for (const int document_id : search_server) {
+            std::set<std::string> words;
+            for (const auto& [word, term_frequency] : search_server.GetWordFrequencies(document_id)) {
+                words.emplace(word);
+            }
+            word_set_duplicate_count += unique_documents.insert(std::move(words)).second ? 0 : 1;
+        }
+    }
+
+    size_t sequential_duplicate_count = 0;
+    {
+        LOG_DURATION_STREAM("  fingerprints, seq"s, std::cout);
+        sequential_duplicate_count = remove_duplicates::FindDuplicates(std::execution::seq, search_server).size();
+    }
+
+    size_t parallel_duplicate_count = 0;
+    {
+        LOG_DURATION_STREAM("  fingerprints, par"s, std::cout);
+        parallel_duplicate_count = remove_duplicates::FindDuplicates(std::execution::par, search_server).size();
+    }
+
+    std::cout << "  duplicates: "s << word_set_duplicate_count << ", "s << sequential_duplicate_count << ", "s
+              << parallel_duplicate_count << std::endl;
+}
+
+// clusters documents of which a quarter are copies of earlier ones with a few words replaced
+void BenchmarkNearDuplicates() {
+    constexpr int kNearDuplicateDocumentCount = 100'000;
+    constexpr int kReplacedWordCount = 4;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize, kMaxWordLength);
+
+    std::vector<std::vector<std::string>> document_words;
+    std::vector<int> source_document_ids(kNearDuplicateDocumentCount, -1);
+    document_words.reserve(kNearDuplicateDocumentCount);
+
+    for (int i = 0; i < kNearDuplicateDocumentCount; ++i) {
+        if (i % 4 == 3) {
+            source_document_ids[i] = std::uniform_int_distribution(0, i - 1)(generator);
+            document_words.push_back(document_words[source_document_ids[i]]);
+
+            for (int j = 0; j < kReplacedWordCount; ++j) {
+                document_words.back()[std::uniform_int_distribution(0, kWordsInDocument - 1)(generator)] =
+                    dictionary[std::uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+            }
+        } else {
+            document_words.emplace_back();
+            for (int j = 0; j < kWordsInDocument; ++j) {
+                document_words.back().push_back(
+                    dictionary[std::uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)]);
+            }
+        }
+    }
+
+    std::vector<std::string> texts;
+    texts.reserve(kNearDuplicateDocumentCount);
+    for (const auto& words : document_words) {
+        texts.emplace_back();
+        for (const std::string& word : words) {
+            texts.back() += texts.back().empty() ? word : " "s + word;
+        }
+    }
+
+    std::vector<SearchServer::NewDocument> documents;
+    documents.reserve(kNearDuplicateDocumentCount);
+    for (int i = 0; i < kNearDuplicateDocumentCount; ++i) {
+        documents.push_back({i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+
+    SearchServer search_server;
+    search_server.AddDocuments(documents);
+
+    std::cout << "Clustering near duplicates of "s << kNearDuplicateDocumentCount << " documents"s << std::endl;
+
+    {
+        LOG_DURATION_STREAM("  MinHash and LSH, seq"s, std::cout);
+        remove_duplicates::FindNearDuplicates(std::execution::seq, search_server);
+    }
+
+    std::vector<std::vector<int>> clusters;
+    {
+        LOG_DURATION_STREAM("  MinHash and LSH, par"s, std::cout);
+        clusters = remove_duplicates::FindNearDuplicates(std::execution::par, search_server);
+    }
+
+    std::vector<int> cluster_of_document(kNearDuplicateDocumentCount, -1);
+    for (size_t cluster = 0; cluster < clusters.size(); ++cluster) {
+        for (const int document_id : clusters[cluster]) {
+            cluster_of_document[document_id] = static_cast<int>(cluster);
+        }
+    }
+
+    int found_copy_count = 0;
+    int copy_count = 0;
+    for (int i = 0; i < kNearDuplicateDocumentCount; ++i) {
+        if (source_document_ids[i] >= 0) {
+            ++copy_count;
+            found_copy_count +=
+                cluster_of_document[i] >= 0 && cluster_of_document[i] == cluster_of_document[source_document_ids[i]];
+        }
+    }
+
+    std::cout << "  clusters: "s << clusters.size() << ", copies found: "s << found_copy_count << " of "s << copy_count
+              << std::endl;
+}
+
+#ifdef __GLIBC__
+size_t GetAllocatedHeapBytes() { return mallinfo2().uordblks; }
+#else
+size_t GetAllocatedHeapBytes() { return 0; }
+#endif
+
+// heap taken by the text of many distinct words, kept in the arena of WordStorage or in a list of strings
+void BenchmarkSnapshot() {
+    constexpr int kSnapshotDocumentCount = 100'000;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize * 10, kMaxWordLength);
+
+    std::vector<std::string> texts;
+    texts.reserve(kSnapshotDocumentCount);
+    for (int i = 0; i < kSnapshotDocumentCount; ++i) {
+        texts.push_back(GenerateQuery(generator, dictionary, kWordsInDocument));
+    }
+
+    std::vector<SearchServer::NewDocument> documents;
+    documents.reserve(kSnapshotDocumentCount);
+    for (int i = 0; i < kSnapshotDocumentCount; ++i) {
+        documents.push_back({i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+
+    std::cout << "Snapshot of "s << kSnapshotDocumentCount << " documents"s << std::endl;
+
+    const auto measure = [](const std::string& name, auto action) {
+        const auto start_time = std::chrono::steady_clock::now();
+        action();
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start_time;
+
+        std::cout << "  "s << name << ": "s << static_cast<int>(duration.count() * 1000) << " ms"s << std::endl;
+    };
+
+    SearchServer search_server("and with"s);
+    measure("reindex"s, [&]() { search_server.AddDocuments(documents); });
+
+    std::stringstream snapshot;
+    measure("save"s, [&]() { search_server.SaveSnapshot(snapshot); });
+
+    std::cout << "  size: "s << snapshot.str().size() / (1024 * 1024) << " MiB"s << std::endl;
+
+    measure("load"s, [&]() {
+        const SearchServer loaded = SearchServer::LoadSnapshot(snapshot);
+        if (loaded.GetDocumentCount() != search_server.GetDocumentCount()) {
+            std::cout << "  loaded snapshot differs from the server"s << std::endl;
+        }
+    });
+}
+
+void BenchmarkMappedSearchServer() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize, kMaxWordLength);
+    const auto search_server = GenerateSearchServer(generator, dictionary, kDocumentCount, kWordsInDocument);
+    const auto queries = GenerateQueries(generator, dictionary, kQueryCount, kWordsInQuery);
+
+    const std::string path = (std::filesystem::temp_directory_path() / "benchmark_search_server.snapshot"s).string();
+
+    {
+        std::ofstream output(path, std::ios::binary);
+        search_server.SaveSnapshot(output);
+    }
+
+    std::cout << "MappedSearchServer, "s << kDocumentCount << " documents x "s << kQueryCount << " queries"s
+              << std::endl;
+
+    {
+        std::optional<MappedSearchServer> mapped_search_server;
+
+        {
+            LOG_DURATION_STREAM("  open"s, std::cout);
+            mapped_search_server.emplace(path);
+        }
+
+        {
+            LOG_DURATION_STREAM("  mapped"s, std::cout);
+
+            for (const std::string& query : queries) {
+                mapped_search_server->FindTopDocuments(query, DocumentStatus::ACTUAL);
+            }
+        }
+
+        {
+            LOG_DURATION_STREAM("  in memory"s, std::cout);
+
+            for (const std::string& query : queries) {
+                search_server.FindTopDocuments(query, DocumentStatus::ACTUAL);
+            }
+        }
+    }
+
+    std::filesystem::remove(path);
+}
+
+void BenchmarkSegmentedIngest() {
+    constexpr int kIngestDocumentCount = 100'000;
+    constexpr int kReportEvery = 20'000;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize * 10, kMaxWordLength);
+
+    std::vector<std::string> texts;
+    texts.reserve(kIngestDocumentCount);
+    for (int i = 0; i < kIngestDocumentCount; ++i) {
+        texts.push_back(GenerateQuery(generator, dictionary, kWordsInDocument));
+    }
+
+    std::cout << "Ingest latency while the index grows, us per document"s << std::endl;
+
+    const auto report = [&texts](const std::string& name, auto add_document) {
+        std::cout << "  "s << name << ":"s;
+
+        for (int first = 0; first < kIngestDocumentCount; first += kReportEvery) {
+            const auto start_time = std::chrono::steady_clock::now();
+
+            for (int document_id = first; document_id < first + kReportEvery; ++document_id) {
+                add_document(document_id, texts[document_id]);
+            }
+
+            const std::chrono::duration<double, std::micro> duration = std::chrono::steady_clock::now() - start_time;
+            std::cout << ' ' << duration.count() / kReportEvery;
+        }
+
+        std::cout << std::endl;
+    };
+
+    {
+        SearchServer search_server("and with"s);
+        report("SearchServer"s, [&search_server](int document_id, const std::string& text) {
+            search_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, {1, 2, 3});
+        });
+    }
+
+    {
+        SegmentedSearchServer search_server("and with"s);
+        report("SegmentedSearchServer"s, [&search_server](int document_id, const std::string& text) {
+            search_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, {1, 2, 3});
+        });
+    }
+}
+
+// Top 5 of Zipf-distributed queries over a Zipf-distributed corpus, with and without dynamic pruning
+void BenchmarkMaxScoreRetrieval() {
+    constexpr int kZipfDocumentCount = 100'000;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize * 10, kMaxWordLength);
+    auto rank_distribution = MakeZipfDistribution(dictionary.size());
+
+    SearchServer search_server("and with"s);
+    for (int document_id = 0; document_id < kZipfDocumentCount; ++document_id) {
+        search_server.AddDocument(document_id,
+                                  GenerateZipfText(generator, dictionary, rank_distribution, kWordsInDocument),
+                                  DocumentStatus::ACTUAL, {document_id % 10});
+    }
+
+    std::cout << "Top 5 of Zipf queries, "s << kZipfDocumentCount << " documents x "s << kQueryCount << " queries"s
+              << std::endl;
+
+    std::vector<std::pair<std::string, std::vector<std::string>>> query_sets;
+
+    for (const int words_in_query : {2, kWordsInQuery}) {
+        std::vector<std::string> queries;
+        for (int i = 0; i < kQueryCount; ++i) {
+            queries.push_back(GenerateZipfText(generator, dictionary, rank_distribution, words_in_query));
+        }
+        query_sets.emplace_back(std::to_string(words_in_query) + " words"s, std::move(queries));
+    }
+
+    // one of the most frequent words with two rare ones
+    {
+        std::vector<std::string> queries;
+        for (int i = 0; i < kQueryCount; ++i) {
+            const auto rare_word = [&]() {
+                return dictionary[std::uniform_int_distribution<size_t>(1'000, dictionary.size() - 1)(generator)];
+            };
+            queries.push_back(dictionary[std::uniform_int_distribution<size_t>(0, 9)(generator)] + " "s + rare_word() +
+                              " "s + rare_word());
+        }
+        query_sets.emplace_back("long tail"s, std::move(queries));
+    }
+
+    for (const auto& [query_set_name, queries] : query_sets) {
+        for (const auto& [name, retrieval_mode] :
+             {std::pair{"exhaustive"s, SearchServer::RetrievalMode::EXHAUSTIVE},
+              std::pair{"max score"s, SearchServer::RetrievalMode::MAX_SCORE}}) {
+            search_server.SetRetrievalMode(retrieval_mode);
+
+            LOG_DURATION_STREAM("  "s + query_set_name + ", "s + name, std::cout);
+
+            for (const std::string& query : queries) {
+                search_server.FindTopDocuments(std::execution::seq, query, DocumentStatus::ACTUAL);
+            }
+        }
+    }
+}
+
+// Memory and query time of compressed postings against the flat arrays of SearchServer, both walked MaxScore style
+void BenchmarkCompressedPostings() {
+    constexpr int kZipfDocumentCount = 100'000;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize * 10, kMaxWordLength);
+    auto rank_distribution = MakeZipfDistribution(dictionary.size());
+
+    SearchServer search_server("and with"s);
+    for (int document_id = 0; document_id < kZipfDocumentCount; ++document_id) {
+        search_server.AddDocument(document_id,
+                                  GenerateZipfText(generator, dictionary, rank_distribution, kWordsInDocument),
+                                  DocumentStatus::ACTUAL, {document_id % 10});
+    }
+
+    std::optional<CompressedSearchServer> compressed_search_server;
+
+    {
+        LOG_DURATION_STREAM("Compressing "s + std::to_string(kZipfDocumentCount) + " Zipf documents"s, std::cout);
+        compressed_search_server.emplace(search_server);
+    }
+
+    // a document id and a term frequency per posting, and the same per block
+    const size_t posting_count = compressed_search_server->GetPostingCount();
+    const size_t flat_bytes = (posting_count + posting_count / search_server_storage_container::PostingList::kBlockSize) *
+                              (sizeof(int) + sizeof(double));
+    const size_t compressed_bytes = compressed_search_server->GetPostingMemoryUsage();
+
+    std::cout << "  "s << posting_count << " postings: flat "s << flat_bytes / 1024 << " KiB, compressed "s
+              << compressed_bytes / 1024 << " KiB, "s << static_cast<double>(compressed_bytes) / posting_count
+              << " bytes per posting"s << std::endl;
+
+    for (const int words_in_query : {2, kWordsInQuery}) {
+        std::vector<std::string> queries;
+        for (int i = 0; i < kQueryCount; ++i) {
+            queries.push_back(GenerateZipfText(generator, dictionary, rank_distribution, words_in_query));
+        }
+
+        {
+            LOG_DURATION_STREAM("  "s + std::to_string(words_in_query) + " words, flat"s, std::cout);
+            for (const std::string& query : queries) {
+                search_server.FindTopDocuments(std::execution::seq, query, DocumentStatus::ACTUAL);
+            }
+        }
+
+        {
+            LOG_DURATION_STREAM("  "s + std::to_string(words_in_query) + " words, compressed"s, std::cout);
+            for (const std::string& query : queries) {
+                compressed_search_server->FindTopDocuments(query, DocumentStatus::ACTUAL);
+            }
+        }
+    }
+}
+
+// Query latency while a writer keeps adding documents: a server behind a reader-writer lock against versions
+void BenchmarkQueryLatencyUnderIngest() {
+    constexpr int kIngestDocumentCount = 20'000;
+
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, kDictionarySize, kMaxWordLength);
+    const auto queries = GenerateQueries(generator, dictionary, kQueryCount, kWordsInQuery);
+
+    std::vector<std::string> texts;
+    texts.reserve(kDocumentCount + kIngestDocumentCount);
+    for (int i = 0; i < kDocumentCount + kIngestDocumentCount; ++i) {
+        texts.push_back(GenerateQuery(generator, dictionary, kWordsInDocument));
+    }
+
+    std::cout << "Query latency while "s << kIngestDocumentCount << " documents are added to "s << kDocumentCount
+              << ", us"s << std::endl;
+
+    // the writer adds the documents after the first kDocumentCount, queries run until it is done
+    const auto report = [&texts, &queries](const std::string& name, auto add_document, auto find_top_documents) {
+        for (int document_id = 0; document_id < kDocumentCount; ++document_id) {
+            add_document(document_id, texts[document_id]);
+        }
+
+        std::atomic<bool> is_writing = true;
+        std::thread writer([&]() {
+            for (int document_id = kDocumentCount; document_id < kDocumentCount + kIngestDocumentCount; ++document_id) {
+                add_document(document_id, texts[document_id]);
+            }
+            is_writing = false;
+        });
+
+        std::vector<double> latencies;
+        for (size_t query_index = 0; is_writing; query_index = (query_index + 1) % queries.size()) {
+            const auto start_time = std::chrono::steady_clock::now();
+            find_top_documents(queries[query_index]);
+
+            const std::chrono::duration<double, std::micro> duration = std::chrono::steady_clock::now() - start_time;
+            latencies.push_back(duration.count());
+        }
+
+        writer.join();
+
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile = [&latencies](double fraction) {
+            return latencies.empty() ? 0.0 : latencies[static_cast<size_t>(fraction * (latencies.size() - 1))];
+        };
+
+        std::cout << "  "s << name << ": "s << latencies.size() << " queries, p50 "s << percentile(0.5) << ", p99 "s
+                  << percentile(0.99) << ", max "s << percentile(1.0) << std::endl;
+    };
+
+    {
+        SearchServer search_server("and with"s);
+        std::shared_mutex mutex;
+
+        report(
+            "SearchServer with shared_mutex"s,
+            [&](int document_id, const std::string& text) {
+                std::unique_lock lock(mutex);
+                search_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, {1, 2, 3});
+            },
+            [&](const std::string& query) {
+                std::shared_lock lock(mutex);
+                search_server.FindTopDocuments(query, DocumentStatus::ACTUAL);
+            });
+    }
+
+    {
+        SegmentedSearchServer search_server("and with"s);
+
+        report(
+            "SegmentedSearchServer"s,
+            [&](int document_id, const std::string& text) {
+                search_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, {1, 2, 3});
+            },
+            [&](const std::string& query) { search_server.FindTopDocuments(query, DocumentStatus::ACTUAL); });
+    }
+}
+
+void BenchmarkWordStorageMemory() {
+    constexpr int kTermCount = 1'000'000;
+    constexpr int kMaxTermLength = 24;
+
+    std::mt19937 generator;
+
+    std::vector<std::string> terms;
+    terms.reserve(kTermCount);
+    for (int i = 0; i < kTermCount; ++i) {
+        terms.push_back(GenerateWord(generator, kMaxTermLength) + std::to_string(i));
+    }
+
+    std::cout << "Word text memory, "s << kTermCount << " distinct words"s << std::endl;
+
+    {
+        const size_t heap_before = GetAllocatedHeapBytes();
+
+        std::list<std::string> list_of_strings;
+        for (const std::string& term : terms) {
+            list_of_strings.emplace_back(std::string_view(term));
+        }
+
+        const size_t heap_bytes = GetAllocatedHeapBytes() - heap_before;
+        std::cout << "  std::list<std::string>: "s << static_cast<double>(heap_bytes) / kTermCount
+                  << " bytes per word"s << std::endl;
+    }
+
+    {
+        const size_t heap_before = GetAllocatedHeapBytes();
+
+        search_server_storage_container::StringArena arena;
+        for (const std::string& term : terms) {
+            arena.Store(term);
+        }
+
+        const size_t heap_bytes = GetAllocatedHeapBytes() - heap_before;
+        const auto& statistics = arena.GetMemoryStatistics();
+
+        std::cout << "  StringArena: "s << static_cast<double>(heap_bytes) / kTermCount << " bytes per word ("s
+                  << statistics.bytes_used << " used / "s << statistics.bytes_reserved << " reserved in "s
+                  << statistics.chunk_count << " chunks)"s << std::endl;
+    }
+}
+
+}  // namespace
+
+void BenchmarkSearchServer() {
+    BenchmarkPostingListScan();
+    BenchmarkFindTopDocuments();
+    BenchmarkProcessQueriesJoined();
+    BenchmarkResultCache();
+    BenchmarkRequestQueues();
+    BenchmarkMaxScoreRetrieval();
+    BenchmarkCompressedPostings();
+    BenchmarkParallelScoringScaling();
+    BenchmarkMatchDocuments();
+    BenchmarkTokenizer();
+    BenchmarkWordStorageMemory();
+    BenchmarkAddDocuments();
+    BenchmarkRemoveDocuments();
+    BenchmarkRemoveDuplicates();
+    BenchmarkNearDuplicates();
+    BenchmarkSnapshot();
+    BenchmarkMappedSearchServer();
+    BenchmarkSegmentedIngest();
+    BenchmarkQueryLatencyUnderIngest();
+}
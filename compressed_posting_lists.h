@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "integer_codec.h"
+#include "posting_list.h"
+#include "word_storage.h"
+
+namespace search_server_storage_container {
+
+// Read-only posting lists of a whole index, compressed into a few flat arrays. Postings keep the blocks of
+// PostingList, and a block keeps its last document id and largest term frequency uncompressed, so queries skip blocks
+// without decoding them. Inside a block document ids are stored as gaps and term frequencies as codes into a table of
+// the distinct frequencies of the index, most used first, both packed with StreamVByte: a gap in a common word or
+// a common frequency takes a byte. Frequencies are looked up, not approximated, so scores stay exact
+class CompressedPostingLists {
+   public:
+    static constexpr size_t kBlockSize = PostingList::kBlockSize;
+
+    CompressedPostingLists() = default;
+
+    // posting_lists are indexed by term id
+    explicit CompressedPostingLists(const std::vector<PostingList>& posting_lists) {
+        const auto term_frequency_codes = BuildTermFrequencyTable(posting_lists);
+
+        list_first_blocks_.reserve(posting_lists.size() + 1);
+        list_sizes_.reserve(posting_lists.size());
+        list_max_term_frequencies_.reserve(posting_lists.size());
+
+        std::vector<uint32_t> values;
+
+        for (const PostingList& posting_list : posting_lists) {
+            list_first_blocks_.push_back(block_offsets_.size());
+            list_sizes_.push_back(static_cast<uint32_t>(posting_list.Size()));
+            list_max_term_frequencies_.push_back(posting_list.GetMaxTermFrequency());
+
+            const auto& document_ids = posting_list.GetDocumentIds();
+            const auto& term_frequencies = posting_list.GetTermFrequencies();
+
+            for (size_t first = 0; first < document_ids.size(); first += kBlockSize) {
+                const size_t last = std::min(first + kBlockSize, document_ids.size());
+                const auto base = static_cast<uint32_t>(first == 0 ? 0 : document_ids[first - 1]);
+
+                block_offsets_.push_back(data_.size());
+
+                values.assign(document_ids.begin() + first, document_ids.begin() + last);
+                integer_codec::EncodeDeltas(values.data(), values.size(), base, data_);
+
+                block_term_frequency_offsets_.push_back(static_cast<uint16_t>(data_.size() - block_offsets_.back()));
+
+                values.clear();
+                for (size_t index = first; index < last; ++index) {
+                    values.push_back(term_frequency_codes.at(term_frequencies[index]));
+                }
+                integer_codec::EncodeStreamVByte(values.data(), values.size(), data_);
+            }
+
+            block_last_document_ids_.insert(block_last_document_ids_.end(),
+                                            posting_list.GetBlockLastDocumentIds().begin(),
+                                            posting_list.GetBlockLastDocumentIds().end());
+            block_max_term_frequencies_.insert(block_max_term_frequencies_.end(),
+                                               posting_list.GetBlockMaxTermFrequencies().begin(),
+                                               posting_list.GetBlockMaxTermFrequencies().end());
+        }
+
+        list_first_blocks_.push_back(block_offsets_.size());
+
+        // the decoder may read past the last block
+        data_.resize(data_.size() + integer_codec::kDecodePadding, 0);
+        data_.shrink_to_fit();
+    }
+
+    size_t GetListCount() const { return list_sizes_.size(); }
+
+    size_t GetListSize(TermId term_id) const { return list_sizes_[term_id]; }
+
+    double GetMaxTermFrequency(TermId term_id) const { return list_max_term_frequencies_[term_id]; }
+
+    // Blocks of the list are [GetFirstBlock(term_id), GetFirstBlock(term_id + 1)), numbered across all lists
+    size_t GetFirstBlock(TermId term_id) const { return list_first_blocks_[term_id]; }
+
+    int GetBlockLastDocumentId(size_t block) const { return block_last_document_ids_[block]; }
+
+    double GetBlockMaxTermFrequency(size_t block) const { return block_max_term_frequencies_[block]; }
+
+    // Decodes the document ids of a block of the term's list into document_ids, which must have room for kBlockSize.
+    // Returns the number of postings in the block
+    size_t DecodeDocumentIds(TermId term_id, size_t block, uint32_t* document_ids) const {
+        const size_t first_block = list_first_blocks_[term_id];
+        const size_t count = GetBlockSize(term_id, block);
+        const auto base = static_cast<uint32_t>(block == first_block ? 0 : block_last_document_ids_[block - 1]);
+
+        integer_codec::DecodeDeltas(data_.data() + block_offsets_[block], count, base, document_ids);
+
+        return count;
+    }
+
+    // Decodes the term frequencies of a block of the term's list, term_frequencies must have room for kBlockSize
+    void DecodeTermFrequencies(TermId term_id, size_t block, double* term_frequencies) const {
+        uint32_t codes[kBlockSize];
+        const size_t count = GetBlockSize(term_id, block);
+
+        integer_codec::DecodeStreamVByte(data_.data() + block_offsets_[block] + block_term_frequency_offsets_[block],
+                                         count, codes);
+
+        for (size_t index = 0; index < count; ++index) {
+            term_frequencies[index] = term_frequency_values_[codes[index]];
+        }
+    }
+
+    bool Contains(TermId term_id, int document_id) const {
+        const auto first = block_last_document_ids_.begin() + list_first_blocks_[term_id];
+        const auto last = block_last_document_ids_.begin() + list_first_blocks_[term_id + 1];
+        const auto block_position = std::lower_bound(first, last, document_id);
+
+        if (block_position == last) {
+            return false;
+        }
+
+        uint32_t document_ids[kBlockSize];
+        const size_t count =
+            DecodeDocumentIds(term_id, static_cast<size_t>(block_position - block_last_document_ids_.begin()),
+                              document_ids);
+
+        return std::binary_search(document_ids, document_ids + count, static_cast<uint32_t>(document_id));
+    }
+
+    // Postings of all lists
+    size_t GetPostingCount() const {
+        size_t posting_count = 0;
+        for (const uint32_t list_size : list_sizes_) {
+            posting_count += list_size;
+        }
+        return posting_count;
+    }
+
+    // Bytes taken by the postings, block metadata and lists included
+    size_t GetMemoryUsage() const {
+        return data_.size() + block_offsets_.size() * sizeof(uint64_t) +
+               block_term_frequency_offsets_.size() * sizeof(uint16_t) +
+               block_last_document_ids_.size() * sizeof(int) + block_max_term_frequencies_.size() * sizeof(double) +
+               list_first_blocks_.size() * sizeof(uint64_t) + list_sizes_.size() * sizeof(uint32_t) +
+               list_max_term_frequencies_.size() * sizeof(double) + term_frequency_values_.size() * sizeof(double);
+    }
+
+   private:
+    size_t GetBlockSize(TermId term_id, size_t block) const {
+        const size_t first_posting = (block - list_first_blocks_[term_id]) * kBlockSize;
+        return std::min(kBlockSize, list_sizes_[term_id] - first_posting);
+    }
+
+    // Codes distinct frequencies by how often they are used, so the common ones get the short codes. Returns the code
+    // of every frequency
+    std::unordered_map<double, uint32_t> BuildTermFrequencyTable(const std::vector<PostingList>& posting_lists) {
+        std::unordered_map<double, size_t> uses;
+
+        for (const PostingList& posting_list : posting_lists) {
+            for (const double term_frequency : posting_list.GetTermFrequencies()) {
+                ++uses[term_frequency];
+            }
+        }
+
+        std::vector<std::pair<size_t, double>> values_by_uses;
+        values_by_uses.reserve(uses.size());
+        for (const auto& [term_frequency, use_count] : uses) {
+            values_by_uses.emplace_back(use_count, term_frequency);
+        }
+
+        // ties by value, so equal indexes get equal tables
+        std::sort(values_by_uses.begin(), values_by_uses.end(), [](const auto& left, const auto& right) {
+            return left.first != right.first ? left.first > right.first : left.second < right.second;
+        });
+
+        std::unordered_map<double, uint32_t> codes;
+        codes.reserve(values_by_uses.size());
+        term_frequency_values_.reserve(values_by_uses.size());
+
+        for (const auto& [use_count, term_frequency] : values_by_uses) {
+            codes.emplace(term_frequency, static_cast<uint32_t>(term_frequency_values_.size()));
+            term_frequency_values_.push_back(term_frequency);
+        }
+
+        return codes;
+    }
+
+   private:
+    // indexed by term id, list_first_blocks_ has one more entry closing the last list
+    std::vector<uint64_t> list_first_blocks_;
+    std::vector<uint32_t> list_sizes_;
+    std::vector<double> list_max_term_frequencies_;
+
+    // indexed by block: where its gaps start in data_, and where its codes start relative to that
+    std::vector<uint64_t> block_offsets_;
+    std::vector<uint16_t> block_term_frequency_offsets_;
+    std::vector<int> block_last_document_ids_;
+    std::vector<double> block_max_term_frequencies_;
+
+    std::vector<uint8_t> data_;
+
+    // frequency of every code
+    std::vector<double> term_frequency_values_;
+};
+
+}  // namespace search_server_storage_container
@@ -0,0 +1,140 @@
+#include "compressed_search_server.h"
+
+#include <algorithm>
+#include <execution>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std::literals;
+
+CompressedSearchServer::CompressedSearchServer(const SearchServer& search_server)
+    : query_parser_(search_server.stop_words_) {
+    const size_t term_count = search_server.posting_lists_.size();
+
+    if (search_server.removed_document_count_ == 0) {
+        posting_lists_ = search_server_storage_container::CompressedPostingLists(search_server.posting_lists_);
+    } else {
+        // removed documents are left out
+        std::vector<search_server_storage_container::PostingList> live_posting_lists;
+        live_posting_lists.reserve(term_count);
+
+        for (TermId term_id = 0; term_id < term_count; ++term_id) {
+            live_posting_lists.push_back(search_server.GetLivePostings(term_id));
+        }
+
+        posting_lists_ = search_server_storage_container::CompressedPostingLists(live_posting_lists);
+    }
+
+    // inserted in term id order, so every word keeps its id
+    words_storage_.Reserve(term_count);
+    inverse_document_frequencies_.reserve(term_count);
+
+    for (TermId term_id = 0; term_id < term_count; ++term_id) {
+        words_storage_.Insert(search_server.words_storage_.GetWord(term_id));
+        inverse_document_frequencies_.push_back(search_server.GetDocumentFrequency(term_id) == 0
+                                                    ? 0.0
+                                                    : search_server.GetWordInverseDocumentFrequency(term_id));
+    }
+
+    document_ids_.reserve(search_server.document_id_to_document_data_.size());
+    ratings_.reserve(search_server.document_id_to_document_data_.size());
+    statuses_.reserve(search_server.document_id_to_document_data_.size());
+
+    for (const auto& [document_id, document_data] : search_server.document_id_to_document_data_) {
+        document_ids_.push_back(document_id);
+        ratings_.push_back(document_data.rating);
+        statuses_.push_back(document_data.status);
+    }
+}
+
+int CompressedSearchServer::GetDocumentCount() const { return static_cast<int>(document_ids_.size()); }
+
+std::vector<int>::const_iterator CompressedSearchServer::begin() const { return document_ids_.begin(); }
+
+std::vector<int>::const_iterator CompressedSearchServer::end() const { return document_ids_.end(); }
+
+size_t CompressedSearchServer::GetPostingCount() const { return posting_lists_.GetPostingCount(); }
+
+size_t CompressedSearchServer::GetPostingMemoryUsage() const { return posting_lists_.GetMemoryUsage(); }
+
+std::vector<Document> CompressedSearchServer::FindTopDocuments(const std::string_view raw_query,
+                                                               const DocumentStatus& desired_status,
+                                                               int max_result_document_count) const {
+    const auto predicate = [desired_status](int, DocumentStatus document_status, int) {
+        return document_status == desired_status;
+    };
+
+    return FindTopDocuments(raw_query, predicate, max_result_document_count);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> CompressedSearchServer::MatchDocument(
+    const std::string_view raw_query, const int document_id) const {
+    const size_t position = FindDocument(document_id);
+
+    if (position == document_ids_.size()) {
+        throw std::out_of_range("no document with id "s + std::to_string(document_id));
+    }
+
+    const DocumentStatus status = statuses_[position];
+    const Query query = ParseQuery(raw_query);
+
+    const auto word_checker = [this, document_id](const QueryWord& word) {
+        return posting_lists_.Contains(word.term_id, document_id);
+    };
+
+    std::vector<std::string_view> matched_words;
+
+    if (std::any_of(query.minus_words.begin(), query.minus_words.end(), word_checker)) {
+        return {matched_words, status};
+    }
+
+    for (const auto& word : query.plus_words) {
+        if (word_checker(word)) {
+            matched_words.push_back(words_storage_.GetWord(word.term_id));
+        }
+    }
+
+    std::sort(matched_words.begin(), matched_words.end());
+
+    return {matched_words, status};
+}
+
+CompressedSearchServer::Query CompressedSearchServer::ParseQuery(const std::string_view raw_query) const {
+    const SearchServer::Query parsed_query = query_parser_.ParseQuery(std::execution::seq, raw_query);
+
+    Query query;
+
+    // words that are not in any document are dropped
+    const auto bind_words = [this](const std::set<std::string_view>& words, std::vector<QueryWord>& query_words,
+                                   bool is_plus) {
+        for (const std::string_view word : words) {
+            const auto term_id = words_storage_.Find(word);
+
+            if (term_id && posting_lists_.GetListSize(*term_id) > 0) {
+                query_words.push_back({*term_id, is_plus ? inverse_document_frequencies_[*term_id] : 0.0});
+            }
+        }
+
+        // rare words first, like SearchServer orders them
+        std::stable_sort(query_words.begin(), query_words.end(), [this](const QueryWord& left, const QueryWord& right) {
+            return posting_lists_.GetListSize(left.term_id) < posting_lists_.GetListSize(right.term_id);
+        });
+    };
+
+    bind_words(parsed_query.plus_words, query.plus_words, true);
+    bind_words(parsed_query.minus_words, query.minus_words, false);
+
+    return query;
+}
+
+size_t CompressedSearchServer::FindDocument(int document_id) const {
+    const auto position = std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+
+    if (position == document_ids_.end() || *position != document_id) {
+        return document_ids_.size();
+    }
+
+    return static_cast<size_t>(position - document_ids_.begin());
+}
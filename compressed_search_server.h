@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "compressed_posting_lists.h"
+#include "document.h"
+#include "max_score_retrieval.h"
+#include "search_server.h"
+#include "top_k_selector.h"
+#include "word_storage.h"
+
+// Read-only search server keeping its postings compressed, see CompressedPostingLists: a posting takes a few bytes
+// instead of the 12 of a document id and a term frequency. Queries walk the lists MaxScore style a block at a time,
+// a block is decoded with SIMD only when a query stops in it and its frequencies only when one of its postings is
+// scored, while blocks that can not hold a top document are skipped on their uncompressed bounds.
+// Results are the same as of the SearchServer it was built from
+class CompressedSearchServer {
+   public:
+    using TermId = SearchServer::TermId;
+
+    // Copies the documents and compresses the postings of the server, which is not referenced afterwards
+    explicit CompressedSearchServer(const SearchServer& search_server);
+
+   public:
+    int GetDocumentCount() const;
+
+    std::vector<int>::const_iterator begin() const;
+
+    std::vector<int>::const_iterator end() const;
+
+    // Postings of all words, and the bytes they take compressed with their block bounds
+    size_t GetPostingCount() const;
+
+    size_t GetPostingMemoryUsage() const;
+
+    template <typename Predicate>
+    std::vector<Document> FindTopDocuments(
+        const std::string_view raw_query, Predicate predicate,
+        int max_result_document_count = SearchServer::kDefaultMaxResultDocumentCount) const;
+
+    std::vector<Document> FindTopDocuments(
+        const std::string_view raw_query, const DocumentStatus& desired_status = DocumentStatus::ACTUAL,
+        int max_result_document_count = SearchServer::kDefaultMaxResultDocumentCount) const;
+
+    // Throws std::out_of_range if there is no such document
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query,
+                                                                            const int document_id) const;
+
+   private:
+    struct QueryWord {
+        TermId term_id = 0;
+        double inverse_document_frequency = 0.0;
+    };
+
+    // Words of the query found in the index, plus words ordered by posting list length
+    struct Query {
+        std::vector<QueryWord> plus_words;
+        std::vector<QueryWord> minus_words;
+    };
+
+    // Postings of a word consumed from the front, a cursor of max_score_retrieval. Only the block the cursor stops in
+    // is decoded
+    class Cursor {
+       public:
+        Cursor(const search_server_storage_container::CompressedPostingLists& posting_lists, const QueryWord& word,
+               size_t word_index)
+            : posting_lists_(&posting_lists),
+              term_id_(word.term_id),
+              inverse_document_frequency_(word.inverse_document_frequency),
+              max_score_(posting_lists.GetMaxTermFrequency(word.term_id) * word.inverse_document_frequency),
+              word_index_(word_index),
+              block_(posting_lists.GetFirstBlock(word.term_id)),
+              last_block_(posting_lists.GetFirstBlock(word.term_id + 1)) {
+            MoveTo(0);
+        }
+
+        // Document of the current posting, max_score_retrieval::kEndDocumentId once every posting is consumed
+        int64_t GetDocumentId() const { return document_id_; }
+
+        size_t GetWordIndex() const { return word_index_; }
+
+        double GetMaxScore() const { return max_score_; }
+
+        // Score of the current posting
+        double GetScore() {
+            if (decoded_term_frequencies_block_ != block_) {
+                posting_lists_->DecodeTermFrequencies(term_id_, block_, term_frequencies_);
+                decoded_term_frequencies_block_ = block_;
+            }
+
+            return term_frequencies_[position_] * inverse_document_frequency_;
+        }
+
+        // Moves to the block that holds document_id if any posting does, without decoding it. False if every
+        // posting is before document_id, the cursor is exhausted then
+        bool SeekBlock(int64_t document_id) {
+            while (block_ < last_block_ && posting_lists_->GetBlockLastDocumentId(block_) < document_id) {
+                ++block_;
+            }
+
+            if (block_ == last_block_) {
+                document_id_ = max_score_retrieval::kEndDocumentId;
+                return false;
+            }
+
+            return true;
+        }
+
+        // Bounds of the block found by SeekBlock
+        double GetBlockScore() const {
+            return posting_lists_->GetBlockMaxTermFrequency(block_) * inverse_document_frequency_;
+        }
+
+        int GetBlockLastDocumentId() const { return posting_lists_->GetBlockLastDocumentId(block_); }
+
+        // Moves to the first posting with a document id not below document_id
+        void MoveTo(int64_t document_id) {
+            if (document_id_ >= document_id || !SeekBlock(document_id)) {
+                return;
+            }
+
+            if (decoded_block_ != block_) {
+                posting_count_ = posting_lists_->DecodeDocumentIds(term_id_, block_, document_ids_);
+                decoded_block_ = block_;
+                position_ = 0;
+            }
+
+            // the block ends at or after document_id, so the posting is in it. Walking a word moves one posting
+            // at a time, which the first check serves without a search
+            const auto target = static_cast<uint32_t>(document_id);
+
+            if (document_ids_[position_] < target && document_ids_[position_ + 1] >= target) {
+                ++position_;
+            } else {
+                position_ = static_cast<size_t>(
+                    std::lower_bound(document_ids_ + position_, document_ids_ + posting_count_, target) -
+                    document_ids_);
+            }
+            document_id_ = document_ids_[position_];
+        }
+
+        void Next() { MoveTo(document_id_ + 1); }
+
+       private:
+        static constexpr size_t kBlockSize = search_server_storage_container::CompressedPostingLists::kBlockSize;
+        static constexpr size_t kNoBlock = std::numeric_limits<size_t>::max();
+
+        const search_server_storage_container::CompressedPostingLists* posting_lists_ = nullptr;
+        TermId term_id_ = 0;
+        double inverse_document_frequency_ = 0.0;
+        double max_score_ = 0.0;
+        size_t word_index_ = 0;
+
+        size_t block_ = 0;
+        size_t last_block_ = 0;
+        int64_t document_id_ = -1;
+
+        size_t decoded_block_ = kNoBlock;
+        size_t decoded_term_frequencies_block_ = kNoBlock;
+        size_t posting_count_ = 0;
+        size_t position_ = 0;
+        uint32_t document_ids_[kBlockSize] = {};
+        double term_frequencies_[kBlockSize] = {};
+    };
+
+    using Selector = top_k_selection::TopKSelector<Document, decltype(&SearchServer::IsMoreRelevant)>;
+
+   private:
+    // Throws std::invalid_argument if the query is malformed
+    Query ParseQuery(const std::string_view raw_query) const;
+
+    // Position of the document in document_ids_, document_ids_.size() if there is no such document
+    size_t FindDocument(int document_id) const;
+
+    // Same walk as SearchServer::FindTopDocumentsWithMaxScore over the whole id range, see max_score_retrieval
+    template <typename Predicate>
+    void FindTopDocumentsWithMaxScore(const Query& query, Predicate& predicate, Selector& selector) const;
+
+   private:
+    // parses queries, holds no documents
+    const SearchServer query_parser_;
+
+    // same term ids as the source server
+    search_server_storage_container::WordStorage words_storage_;
+    search_server_storage_container::CompressedPostingLists posting_lists_;
+    std::vector<double> inverse_document_frequencies_;
+
+    std::vector<int> document_ids_;
+    std::vector<int> ratings_;
+    std::vector<DocumentStatus> statuses_;
+};
+
+template <typename Predicate>
+std::vector<Document> CompressedSearchServer::FindTopDocuments(const std::string_view raw_query, Predicate predicate,
+                                                               int max_result_document_count) const {
+    if (max_result_document_count < 0) {
+        throw std::invalid_argument("negative result document count is not allowed"s);
+    }
+
+    const Query query = ParseQuery(raw_query);
+
+    Selector selector(static_cast<size_t>(max_result_document_count), &SearchServer::IsMoreRelevant);
+    FindTopDocumentsWithMaxScore(query, predicate, selector);
+
+    return selector.ExtractSorted();
+}
+
+template <typename Predicate>
+void CompressedSearchServer::FindTopDocumentsWithMaxScore(const Query& query, Predicate& predicate,
+                                                          Selector& selector) const {
+    // reused by every query running on this thread
+    thread_local std::vector<Cursor> cursors;
+    thread_local std::vector<Cursor> minus_cursors;
+
+    cursors.clear();
+    for (size_t word_index = 0; word_index < query.plus_words.size(); ++word_index) {
+        cursors.emplace_back(posting_lists_, query.plus_words[word_index], word_index);
+    }
+
+    minus_cursors.clear();
+    for (const QueryWord& word : query.minus_words) {
+        minus_cursors.emplace_back(posting_lists_, word, 0);
+    }
+
+    max_score_retrieval::FindTopDocuments(
+        cursors, minus_cursors, selector, SearchServer::kAccuracy, [](int) { return false; },
+        [&](int document_id, double relevance) {
+            const size_t position = FindDocument(document_id);
+
+            if (predicate(document_id, statuses_[position], ratings_[position])) {
+                selector.Push({document_id, relevance, ratings_[position]});
+            }
+        });
+}
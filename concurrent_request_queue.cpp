@@ -0,0 +1,61 @@
+#include "concurrent_request_queue.h"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std::literals;
+
+ConcurrentRequestQueue::ConcurrentRequestQueue(const SearchServer& search_server, Clock clock)
+    : server_(search_server), clock_(std::move(clock)), start_(clock_()) {}
+
+std::vector<Document> ConcurrentRequestQueue::AddFindRequest(const std::string_view raw_query, DocumentStatus status) {
+    std::vector<Document> results = server_.FindTopDocuments(raw_query, status);
+
+    RecordRequest(results.size());
+
+    return results;
+}
+
+int ConcurrentRequestQueue::GetNoResultRequests() const {
+    return static_cast<int>(GetWindowStatistics(std::chrono::minutes(kMinutesInADay)).no_result_request_count);
+}
+
+ConcurrentRequestQueue::WindowStatistics ConcurrentRequestQueue::GetWindowStatistics(
+    std::chrono::minutes window) const {
+    if (window.count() < 1 || window.count() > kMinutesInADay) {
+        throw std::invalid_argument("statistics window must be from a minute to a day"s);
+    }
+
+    const uint32_t current_minute = GetCurrentMinute();
+    const auto window_minutes = static_cast<uint32_t>(window.count());
+
+    WindowStatistics statistics;
+
+    // a bounded number of loads, whatever writers do meanwhile
+    for (uint32_t age = 0; age < window_minutes && age <= current_minute; ++age) {
+        const uint32_t minute = current_minute - age;
+        const Bucket& bucket = buckets_[minute % kMinutesInADay];
+
+        statistics.request_count += bucket.requests.Get(minute);
+        statistics.no_result_request_count += bucket.no_result_requests.Get(minute);
+    }
+
+    return statistics;
+}
+
+uint32_t ConcurrentRequestQueue::GetCurrentMinute() const {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::minutes>(clock_() - start_);
+    return elapsed.count() < 0 ? 0 : static_cast<uint32_t>(elapsed.count());
+}
+
+void ConcurrentRequestQueue::RecordRequest(size_t result_count) {
+    const uint32_t minute = GetCurrentMinute();
+    Bucket& bucket = buckets_[minute % kMinutesInADay];
+
+    bucket.requests.Increment(minute);
+
+    if (result_count == 0) {
+        bucket.no_result_requests.Increment(minute);
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+// RequestQueue for many threads: requests are counted, not stored, in a ring of per-minute buckets updated with
+// atomics, and a bucket expires when its minute leaves the day, however many requests came since. Adding a request
+// takes no lock and allocates nothing beyond the results, statistics are read wait-free
+class ConcurrentRequestQueue {
+   public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    // Time of a request, the steady clock unless a test supplies its own
+    using Clock = std::function<TimePoint()>;
+
+    struct WindowStatistics {
+        uint64_t request_count = 0;
+        uint64_t no_result_request_count = 0;
+    };
+
+    static constexpr int kMinutesInADay = 1440;
+
+    explicit ConcurrentRequestQueue(const SearchServer& search_server, Clock clock = std::chrono::steady_clock::now);
+
+    ConcurrentRequestQueue(const ConcurrentRequestQueue&) = delete;
+    ConcurrentRequestQueue& operator=(const ConcurrentRequestQueue&) = delete;
+
+   public:
+    template <typename DocumentPredicate>
+    std::vector<Document> AddFindRequest(const std::string_view raw_query, DocumentPredicate document_predicate);
+
+    std::vector<Document> AddFindRequest(const std::string_view raw_query,
+                                         DocumentStatus status = DocumentStatus::ACTUAL);
+
+    // Requests of the last day that found nothing
+    int GetNoResultRequests() const;
+
+    // Requests of the last window minutes, the current one included. Throws std::invalid_argument unless window is
+    // from a minute to a day
+    WindowStatistics GetWindowStatistics(std::chrono::minutes window) const;
+
+   private:
+    // Count of the requests of one minute. The minute and the count share a word, so a bucket moves to a new minute
+    // and restarts its count in one step
+    class MinuteCounter {
+       public:
+        void Increment(uint32_t minute) {
+            uint64_t word = word_.load(std::memory_order_relaxed);
+
+            while (true) {
+                const auto word_minute = static_cast<uint32_t>(word >> 32);
+
+                // a request that stalled for a day is not worth a newer count
+                if (word_minute > minute) {
+                    return;
+                }
+
+                const uint64_t next_word = word_minute == minute ? word + 1 : (uint64_t{minute} << 32) | 1;
+
+                if (word_.compare_exchange_weak(word, next_word, std::memory_order_relaxed)) {
+                    return;
+                }
+            }
+        }
+
+        // 0 if the bucket holds another minute
+        uint32_t Get(uint32_t minute) const {
+            const uint64_t word = word_.load(std::memory_order_relaxed);
+            return static_cast<uint32_t>(word >> 32) == minute ? static_cast<uint32_t>(word) : 0;
+        }
+
+       private:
+        std::atomic<uint64_t> word_ = 0;
+    };
+
+    struct Bucket {
+        MinuteCounter requests;
+        MinuteCounter no_result_requests;
+    };
+
+   private:
+    // Minutes since the queue was made
+    uint32_t GetCurrentMinute() const;
+
+    void RecordRequest(size_t result_count);
+
+   private:
+    const SearchServer& server_;
+    const Clock clock_;
+    const TimePoint start_;
+
+    // the bucket of minute m is m % kMinutesInADay
+    std::array<Bucket, kMinutesInADay> buckets_;
+};
+
+template <typename DocumentPredicate>
+std::vector<Document> ConcurrentRequestQueue::AddFindRequest(const std::string_view raw_query,
+                                                             DocumentPredicate document_predicate) {
+    std::vector<Document> results = server_.FindTopDocuments(raw_query, document_predicate);
+
+    RecordRequest(results.size());
+
+    return results;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace search_server_storage_container {
+
+// Set of non-negative document ids kept as a bit per id, so a lookup is a shift and a mask. The bits only grow while
+// they stay within a few words per id in the set, ids beyond that would make the bitmap as large as the id space and
+// are kept in a hash set instead
+class DocumentBitmap {
+   public:
+    // Words allowed per id in the set, beyond kMinDenseWordCount
+    static constexpr size_t kMaxWordsPerDocument = 4;
+
+    static constexpr size_t kMinDenseWordCount = 1024;
+
+    void Insert(int document_id) {
+        if (Contains(document_id)) {
+            return;
+        }
+
+        ++size_;
+
+        const size_t word = static_cast<size_t>(document_id) / kBitsPerWord;
+
+        if (word >= words_.size()) {
+            if (word >= kMinDenseWordCount + kMaxWordsPerDocument * size_) {
+                sparse_document_ids_.insert(document_id);
+                return;
+            }
+
+            words_.resize(word + 1, 0);
+        }
+
+        words_[word] |= uint64_t{1} << (static_cast<size_t>(document_id) % kBitsPerWord);
+    }
+
+    bool Contains(int document_id) const {
+        const size_t word = static_cast<size_t>(document_id) / kBitsPerWord;
+
+        if (word < words_.size() && (words_[word] >> (static_cast<size_t>(document_id) % kBitsPerWord) & 1) != 0) {
+            return true;
+        }
+
+        // the bits may have grown over an id kept sparse
+        return !sparse_document_ids_.empty() && sparse_document_ids_.count(document_id) != 0;
+    }
+
+    // Frees the bits too
+    void Clear() {
+        words_.clear();
+        words_.shrink_to_fit();
+        sparse_document_ids_ = {};
+        size_ = 0;
+    }
+
+   private:
+    static constexpr size_t kBitsPerWord = 64;
+
+    std::vector<uint64_t> words_;
+    std::unordered_set<int> sparse_document_ids_;
+    size_t size_ = 0;
+};
+
+}  // namespace search_server_storage_container
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace epoch_reclamation {
+
+// Epoch-based reclamation for objects read without locks. A reader pins the current epoch before it loads a shared
+// pointer and unpins when done, a writer swaps the pointer and retires the old object, which is freed once every
+// reader that could have loaded it has unpinned. Readers never wait for writers, and pinning is a single CAS
+class EpochManager {
+   public:
+    // Readers pinned at the same time, further readers wait for a free slot
+    static constexpr size_t kMaxReaders = 256;
+
+    // Keeps the epoch pinned for its lifetime
+    class Guard {
+       public:
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        Guard(Guard&& other) noexcept : slot_(std::exchange(other.slot_, nullptr)) {}
+
+        ~Guard() {
+            if (slot_ != nullptr) {
+                slot_->store(kIdle);
+            }
+        }
+
+       private:
+        friend class EpochManager;
+
+        explicit Guard(std::atomic<uint64_t>* slot) : slot_(slot) {}
+
+       private:
+        std::atomic<uint64_t>* slot_;
+    };
+
+   public:
+    EpochManager() = default;
+
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+    // No reader may be pinned anymore, everything retired is freed
+    ~EpochManager() {
+        for (auto& [epoch, deleter] : retired_) {
+            deleter();
+        }
+    }
+
+   public:
+    // Must be called before loading the shared pointer
+    Guard Pin() {
+        // threads start looking at different slots, so they rarely collide
+        const size_t first_slot = std::hash<std::thread::id>{}(std::this_thread::get_id()) % kMaxReaders;
+
+        while (true) {
+            const uint64_t epoch = global_epoch_.load();
+
+            for (size_t offset = 0; offset < kMaxReaders; ++offset) {
+                std::atomic<uint64_t>& slot = slots_[(first_slot + offset) % kMaxReaders].epoch;
+                uint64_t expected = kIdle;
+
+                if (slot.compare_exchange_strong(expected, epoch)) {
+                    return Guard(&slot);
+                }
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    // Calls deleter once no reader pinned before this call is still pinned. Must be called after the object has been
+    // unlinked from the shared pointer
+    void Retire(std::function<void()> deleter) {
+        const uint64_t retire_epoch = global_epoch_.fetch_add(1);
+
+        {
+            std::lock_guard lock(retired_mutex_);
+            retired_.emplace_back(retire_epoch, std::move(deleter));
+        }
+
+        Collect();
+    }
+
+    // Frees retired objects no reader can hold anymore
+    void Collect() {
+        uint64_t oldest_pinned_epoch = std::numeric_limits<uint64_t>::max();
+
+        for (const Slot& slot : slots_) {
+            if (const uint64_t epoch = slot.epoch.load(); epoch != kIdle) {
+                oldest_pinned_epoch = std::min(oldest_pinned_epoch, epoch);
+            }
+        }
+
+        std::vector<std::function<void()>> deleters;
+
+        {
+            std::lock_guard lock(retired_mutex_);
+
+            // a reader pinned at epoch e may hold anything retired at e or later
+            const auto first_kept = std::partition(retired_.begin(), retired_.end(), [oldest_pinned_epoch](const auto& retired) {
+                return retired.first < oldest_pinned_epoch;
+            });
+
+            for (auto it = retired_.begin(); it != first_kept; ++it) {
+                deleters.push_back(std::move(it->second));
+            }
+
+            retired_.erase(retired_.begin(), first_kept);
+        }
+
+        for (auto& deleter : deleters) {
+            deleter();
+        }
+    }
+
+   private:
+    static constexpr uint64_t kIdle = 0;
+
+    // a slot per cache line, pinning readers do not share lines
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch = kIdle;
+    };
+
+   private:
+    Slot slots_[kMaxReaders];
+    std::atomic<uint64_t> global_epoch_ = 1;
+
+    std::mutex retired_mutex_;
+    std::vector<std::pair<uint64_t, std::function<void()>>> retired_;
+};
+
+}  // namespace epoch_reclamation
@@ -0,0 +1,181 @@
+#include "integer_codec.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define INTEGER_CODEC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace integer_codec {
+
+namespace {
+
+constexpr size_t kGroupSize = 4;
+
+size_t GetGroupCount(size_t count) { return (count + kGroupSize - 1) / kGroupSize; }
+
+// Bytes a value takes, minus one, as it is written to the control byte
+uint8_t GetLengthCode(uint32_t value) {
+    if (value < (1u << 8)) {
+        return 0;
+    }
+    if (value < (1u << 16)) {
+        return 1;
+    }
+    if (value < (1u << 24)) {
+        return 2;
+    }
+    return 3;
+}
+
+// Shuffle masks and data lengths of all 256 control bytes
+struct GroupTable {
+    uint8_t shuffle_masks[256][16] = {};
+    uint8_t lengths[256] = {};
+};
+
+constexpr GroupTable MakeGroupTable() {
+    GroupTable table;
+
+    for (int control = 0; control < 256; ++control) {
+        uint8_t source = 0;
+
+        for (int lane = 0; lane < 4; ++lane) {
+            const int length = ((control >> (2 * lane)) & 3) + 1;
+
+            // bytes past the value's length are zeroed by a mask byte with the high bit set
+            for (int byte = 0; byte < 4; ++byte) {
+                table.shuffle_masks[control][lane * 4 + byte] = byte < length ? source++ : 0x80;
+            }
+        }
+
+        table.lengths[control] = source;
+    }
+
+    return table;
+}
+
+constexpr GroupTable kGroupTable = MakeGroupTable();
+
+void EncodeGroups(const uint32_t* values, size_t count, uint32_t base, bool is_delta, std::vector<uint8_t>& output) {
+    const size_t group_count = GetGroupCount(count);
+
+    const size_t control_offset = output.size();
+    output.resize(output.size() + group_count, 0);
+
+    uint32_t previous = base;
+
+    for (size_t index = 0; index < group_count * kGroupSize; ++index) {
+        uint32_t value = 0;
+
+        if (index < count) {
+            value = is_delta ? values[index] - previous : values[index];
+            previous = values[index];
+        }
+
+        const uint8_t length_code = GetLengthCode(value);
+        output[control_offset + index / kGroupSize] |= static_cast<uint8_t>(length_code << (2 * (index % kGroupSize)));
+
+        for (int byte = 0; byte <= length_code; ++byte) {
+            output.push_back(static_cast<uint8_t>(value >> (8 * byte)));
+        }
+    }
+}
+
+using Decoder = const uint8_t* (*)(const uint8_t* input, size_t count, uint32_t base, bool is_delta,
+                                   uint32_t* values);
+
+const uint8_t* DecodeScalar(const uint8_t* input, size_t count, uint32_t base, bool is_delta, uint32_t* values) {
+    const size_t group_count = GetGroupCount(count);
+    const uint8_t* data = input + group_count;
+
+    uint32_t previous = base;
+
+    for (size_t group = 0; group < group_count; ++group) {
+        const uint8_t control = input[group];
+
+        for (size_t lane = 0; lane < kGroupSize; ++lane) {
+            const int length = ((control >> (2 * lane)) & 3) + 1;
+
+            uint32_t value = 0;
+            for (int byte = 0; byte < length; ++byte) {
+                value |= static_cast<uint32_t>(data[byte]) << (8 * byte);
+            }
+            data += length;
+
+            previous = is_delta ? previous + value : value;
+            values[group * kGroupSize + lane] = previous;
+        }
+    }
+
+    return data;
+}
+
+#ifdef INTEGER_CODEC_X86_SIMD
+
+// A group per step: one table lookup, one shuffle and, for gaps, a prefix sum in two shifted adds
+__attribute__((target("ssse3"))) const uint8_t* DecodeSsse3(const uint8_t* input, size_t count, uint32_t base,
+                                                             bool is_delta, uint32_t* values) {
+    const size_t group_count = GetGroupCount(count);
+    const uint8_t* data = input + group_count;
+
+    __m128i previous = _mm_set1_epi32(static_cast<int>(base));
+
+    for (size_t group = 0; group < group_count; ++group) {
+        const uint8_t control = input[group];
+        const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kGroupTable.shuffle_masks[control]));
+        __m128i group_values = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), mask);
+        data += kGroupTable.lengths[control];
+
+        if (is_delta) {
+            group_values = _mm_add_epi32(group_values, _mm_slli_si128(group_values, 4));
+            group_values = _mm_add_epi32(group_values, _mm_slli_si128(group_values, 8));
+            // the last value of the previous group, in every lane
+            group_values = _mm_add_epi32(group_values, _mm_shuffle_epi32(previous, 0xFF));
+            previous = group_values;
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + group * kGroupSize), group_values);
+    }
+
+    return data;
+}
+
+#endif
+
+Decoder SelectDecoder() {
+#ifdef INTEGER_CODEC_X86_SIMD
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("ssse3")) {
+        return DecodeSsse3;
+    }
+#endif
+
+    return DecodeScalar;
+}
+
+const uint8_t* Decode(const uint8_t* input, size_t count, uint32_t base, bool is_delta, uint32_t* values) {
+    static const Decoder decoder = SelectDecoder();
+
+    return decoder(input, count, base, is_delta, values);
+}
+
+}  // namespace
+
+void EncodeStreamVByte(const uint32_t* values, size_t count, std::vector<uint8_t>& output) {
+    EncodeGroups(values, count, 0, false, output);
+}
+
+void EncodeDeltas(const uint32_t* values, size_t count, uint32_t base, std::vector<uint8_t>& output) {
+    EncodeGroups(values, count, base, true, output);
+}
+
+const uint8_t* DecodeStreamVByte(const uint8_t* input, size_t count, uint32_t* values) {
+    return Decode(input, count, 0, false, values);
+}
+
+const uint8_t* DecodeDeltas(const uint8_t* input, size_t count, uint32_t base, uint32_t* values) {
+    return Decode(input, count, base, true, values);
+}
+
+}  // namespace integer_codec
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// StreamVByte coding of 32-bit integers: every value takes 1 to 4 bytes, and the byte lengths of four values are
+// packed into one control byte kept ahead of the data, so a decoder turns a control byte into a shuffle mask and
+// unpacks four values with a single shuffle. Values are coded in groups of four, a count that is not a multiple of
+// four is padded with zeros. SSSE3 is chosen at runtime where available
+namespace integer_codec {
+
+// Decoders read whole 16-byte groups, a buffer of coded data must have this many readable bytes past its end
+inline constexpr size_t kDecodePadding = 16;
+
+// Appends values[0, count) to output
+void EncodeStreamVByte(const uint32_t* values, size_t count, std::vector<uint8_t>& output);
+
+// Appends the gaps between consecutive values, the first one taken from base. values must not decrease and must not
+// be below base
+void EncodeDeltas(const uint32_t* values, size_t count, uint32_t base, std::vector<uint8_t>& output);
+
+// Decodes count values written by EncodeStreamVByte. values must have room for count rounded up to a multiple of
+// four. Returns the end of the coded data
+const uint8_t* DecodeStreamVByte(const uint8_t* input, size_t count, uint32_t* values);
+
+// Decodes values written by EncodeDeltas, prefix sums are taken four lanes at a time
+const uint8_t* DecodeDeltas(const uint8_t* input, size_t count, uint32_t base, uint32_t* values);
+
+}  // namespace integer_codec
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "word_storage.h"
+
+namespace search_server_storage_container {
+
+// IDF of every term, computed on first use and kept until the document count changes. A change only bumps the
+// generation, so writers pay nothing per term and a query recomputes just the words it uses, once per generation.
+// Lookups are safe to run concurrently with each other, Resize and Invalidate need exclusive access
+class InverseDocumentFrequencyCache {
+   public:
+    void Resize(size_t term_count) { entries_.resize(term_count); }
+
+    // Every cached value is stale from now on
+    void Invalidate() { ++generation_; }
+
+    size_t Size() const { return entries_.size(); }
+
+    // Returns the cached IDF of the term or caches compute(). Terms past Size() are computed every time
+    template <typename Compute>
+    double Get(TermId term_id, Compute compute) const {
+        if (term_id >= entries_.size()) {
+            return compute();
+        }
+
+        Entry& entry = entries_[term_id];
+
+        if (entry.generation.load(std::memory_order_acquire) == generation_) {
+            return entry.value.load(std::memory_order_relaxed);
+        }
+
+        // queries racing for the same term store the same value
+        const double value = compute();
+        entry.value.store(value, std::memory_order_relaxed);
+        entry.generation.store(generation_, std::memory_order_release);
+
+        return value;
+    }
+
+   private:
+    struct Entry {
+        Entry() = default;
+
+        // copied only while the cache is resized, which no lookup runs alongside
+        Entry(const Entry& other)
+            : generation(other.generation.load(std::memory_order_relaxed)),
+              value(other.value.load(std::memory_order_relaxed)) {}
+
+        Entry& operator=(const Entry& other) {
+            generation.store(other.generation.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            value.store(other.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+
+        // generation the value was computed in, 0 for never
+        std::atomic<uint64_t> generation = 0;
+        std::atomic<double> value = 0.0;
+    };
+
+   private:
+    mutable std::vector<Entry> entries_;
+    uint64_t generation_ = 1;
+};
+
+}  // namespace search_server_storage_container
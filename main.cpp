@@ -1,15 +1,22 @@
 #include <execution>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "benchmark_search_server.h"
 #include "process_queries.h"
 #include "search_server.h"
 #include "test_search_server.h"
 
-int main() {
+int main(int argc, char* argv[]) {
     TestSearchServer();
 
+    if (argc > 1 && argv[1] == "--benchmark"sv) {
+        BenchmarkSearchServer();
+        return 0;
+    }
+
     SearchServer search_server("and with"s);
 
     int id = 0;
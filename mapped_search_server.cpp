@@ -0,0 +1,320 @@
+#include "mapped_search_server.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "string_processing.h"
+
+using namespace std::literals;
+using namespace search_server_snapshot;
+
+MappedSearchServer::MappedSearchServer(const std::string& path) {
+    const int file_descriptor = open(path.c_str(), O_RDONLY);
+
+    if (file_descriptor < 0) {
+        throw std::invalid_argument("can not open snapshot "s + path);
+    }
+
+    struct stat file_status {};
+    if (fstat(file_descriptor, &file_status) != 0 || file_status.st_size < static_cast<off_t>(sizeof(SnapshotHeader))) {
+        close(file_descriptor);
+        throw std::invalid_argument("not a search server snapshot"s);
+    }
+
+    mapping_size_ = static_cast<size_t>(file_status.st_size);
+    void* mapping = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, file_descriptor, 0);
+
+    // the mapping keeps the file referenced on its own
+    close(file_descriptor);
+
+    if (mapping == MAP_FAILED) {
+        mapping_size_ = 0;
+        throw std::invalid_argument("can not map snapshot "s + path);
+    }
+
+    mapping_ = static_cast<const char*>(mapping);
+
+    try {
+        SnapshotHeader header{};
+        std::memcpy(&header, mapping_, sizeof(header));
+
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+            throw std::invalid_argument("not a search server snapshot"s);
+        }
+
+        if (header.version != kVersion || header.byte_order_mark != kByteOrderMark ||
+            header.section_count != kSectionCount) {
+            throw std::invalid_argument("unsupported snapshot version"s);
+        }
+
+        // only section headers are read, payloads are paged in by the queries that need them
+        size_t offset = sizeof(SnapshotHeader);
+
+        for (const SectionTag tag : {SectionTag::STOP_WORDS, SectionTag::DICTIONARY, SectionTag::LEXICON,
+                                     SectionTag::POSTINGS, SectionTag::DOCUMENTS}) {
+            Section section;
+
+            if (mapping_size_ - offset < sizeof(SectionHeader)) {
+                throw std::invalid_argument("snapshot is truncated"s);
+            }
+            std::memcpy(&section.header, mapping_ + offset, sizeof(SectionHeader));
+            offset += sizeof(SectionHeader);
+
+            if (section.header.tag != tag || section.header.payload_size % kAlignment != 0) {
+                throw std::invalid_argument("snapshot section is malformed"s);
+            }
+
+            if (mapping_size_ - offset < section.header.payload_size) {
+                throw std::invalid_argument("snapshot is truncated"s);
+            }
+
+            section.data = mapping_ + offset;
+            offset += section.header.payload_size;
+
+            sections_.push_back(section);
+        }
+
+        const auto reader = [this](SectionTag tag) {
+            const Section& section = sections_[static_cast<size_t>(tag) - 1];
+            return PayloadReader(section.data, section.header.payload_size);
+        };
+
+        stop_words_ = reader(SectionTag::STOP_WORDS).ReadStrings();
+        words_ = reader(SectionTag::DICTIONARY).ReadStrings();
+        lexicon_ = reader(SectionTag::LEXICON).ReadArray<TermId>();
+
+        PayloadReader postings = reader(SectionTag::POSTINGS);
+        posting_ends_ = postings.ReadArray<uint64_t>();
+        posting_document_ids_ = postings.ReadArray<int>();
+        posting_term_frequencies_ = postings.ReadArray<double>();
+
+        PayloadReader documents = reader(SectionTag::DOCUMENTS);
+        document_ids_ = documents.ReadArray<int>();
+        ratings_ = documents.ReadArray<int>();
+        statuses_ = documents.ReadArray<DocumentStatus>();
+
+        if (lexicon_.size() != words_.size() || posting_ends_.size() != words_.size() ||
+            posting_term_frequencies_.size() != posting_document_ids_.size() ||
+            (!posting_ends_.empty() && posting_ends_.back() != posting_document_ids_.size()) ||
+            ratings_.size() != document_ids_.size() || statuses_.size() != document_ids_.size()) {
+            throw std::invalid_argument("snapshot sections do not agree"s);
+        }
+    } catch (...) {
+        Unmap();
+        throw;
+    }
+}
+
+MappedSearchServer::MappedSearchServer(MappedSearchServer&& other) noexcept { *this = std::move(other); }
+
+MappedSearchServer& MappedSearchServer::operator=(MappedSearchServer&& other) noexcept {
+    if (this != &other) {
+        Unmap();
+
+        // views point into the mapping, which does not move
+        mapping_ = std::exchange(other.mapping_, nullptr);
+        mapping_size_ = std::exchange(other.mapping_size_, 0);
+        sections_ = std::move(other.sections_);
+        stop_words_ = other.stop_words_;
+        words_ = other.words_;
+        lexicon_ = other.lexicon_;
+        posting_ends_ = other.posting_ends_;
+        posting_document_ids_ = other.posting_document_ids_;
+        posting_term_frequencies_ = other.posting_term_frequencies_;
+        document_ids_ = other.document_ids_;
+        ratings_ = other.ratings_;
+        statuses_ = other.statuses_;
+    }
+
+    return *this;
+}
+
+MappedSearchServer::~MappedSearchServer() { Unmap(); }
+
+void MappedSearchServer::Unmap() {
+    if (mapping_ != nullptr) {
+        munmap(const_cast<char*>(mapping_), mapping_size_);
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+    }
+}
+
+int MappedSearchServer::GetDocumentCount() const { return static_cast<int>(document_ids_.size()); }
+
+const int* MappedSearchServer::begin() const { return document_ids_.begin(); }
+
+const int* MappedSearchServer::end() const { return document_ids_.end(); }
+
+bool MappedSearchServer::VerifyChecksums() const {
+    return std::all_of(sections_.begin(), sections_.end(), [](const Section& section) {
+        return ComputeChecksum(section.data, section.header.payload_size) == section.header.checksum;
+    });
+}
+
+std::vector<Document> MappedSearchServer::FindTopDocuments(const std::string_view raw_query,
+                                                           const DocumentStatus& desired_status,
+                                                           int max_result_document_count) const {
+    const auto predicate = [desired_status](int, DocumentStatus document_status, int) {
+        return document_status == desired_status;
+    };
+
+    return FindTopDocuments(raw_query, predicate, max_result_document_count);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> MappedSearchServer::MatchDocument(
+    const std::string_view raw_query, const int document_id) const {
+    const size_t position = FindDocument(document_id);
+
+    if (position == document_ids_.size()) {
+        throw std::out_of_range("no document with id "s + std::to_string(document_id));
+    }
+
+    const DocumentStatus status = statuses_[position];
+    const Query query = ParseQuery(raw_query);
+
+    const auto word_checker = [this, document_id](const QueryWord& word) {
+        const auto [first, last] = GetPostingRange(word.term_id);
+        return std::binary_search(posting_document_ids_.begin() + first, posting_document_ids_.begin() + last,
+                                  document_id);
+    };
+
+    std::vector<std::string_view> matched_words;
+
+    if (std::any_of(query.minus_words.begin(), query.minus_words.end(), word_checker)) {
+        return {matched_words, status};
+    }
+
+    for (const auto& word : query.plus_words) {
+        if (word_checker(word)) {
+            matched_words.push_back(words_[word.term_id]);
+        }
+    }
+
+    std::sort(matched_words.begin(), matched_words.end());
+
+    return {matched_words, status};
+}
+
+MappedSearchServer::Query MappedSearchServer::ParseQuery(const std::string_view raw_query) const {
+    // reused by every query parsed on this thread
+    thread_local std::vector<std::string_view> words;
+
+    if (!string_processing::SplitIntoWordsValidated(raw_query, words)) {
+        throw std::invalid_argument("special symbols in words are not allowed"s);
+    }
+
+    std::vector<std::string_view> plus_words;
+    std::vector<std::string_view> minus_words;
+
+    // same rules and the first error reported, as SearchServer parses queries
+    for (const std::string_view word : words) {
+        const auto query_word = SearchServer::ParseQueryWordSyntax(word);
+
+        if (!query_word.error.empty()) {
+            throw std::invalid_argument(std::string(query_word.error));
+        }
+
+        if (!IsStopWord(query_word.data)) {
+            (query_word.is_minus ? minus_words : plus_words).push_back(query_word.data);
+        }
+    }
+
+    Query query;
+
+    const auto bind_words = [this](std::vector<std::string_view>& words, std::vector<QueryWord>& query_words,
+                                   bool is_plus) {
+        std::sort(words.begin(), words.end());
+        words.erase(std::unique(words.begin(), words.end()), words.end());
+
+        for (const std::string_view word : words) {
+            if (const auto term_id = FindIndexedTerm(word)) {
+                const auto [first, last] = GetPostingRange(*term_id);
+                const double inverse_document_frequency =
+                    is_plus ? std::log(static_cast<double>(GetDocumentCount()) / static_cast<double>(last - first)) : 0.0;
+
+                query_words.push_back({*term_id, inverse_document_frequency});
+            }
+        }
+
+        // rare words first, like SearchServer orders them
+        std::stable_sort(query_words.begin(), query_words.end(), [this](const QueryWord& left, const QueryWord& right) {
+            const auto [left_first, left_last] = GetPostingRange(left.term_id);
+            const auto [right_first, right_last] = GetPostingRange(right.term_id);
+            return left_last - left_first < right_last - right_first;
+        });
+    };
+
+    bind_words(plus_words, query.plus_words, true);
+    bind_words(minus_words, query.minus_words, false);
+
+    return query;
+}
+
+bool MappedSearchServer::IsStopWord(std::string_view word) const {
+    // stop words are stored sorted
+    size_t first = 0;
+    size_t last = stop_words_.size();
+
+    while (first < last) {
+        const size_t middle = first + (last - first) / 2;
+
+        if (stop_words_[middle] < word) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    return first < stop_words_.size() && stop_words_[first] == word;
+}
+
+std::optional<MappedSearchServer::TermId> MappedSearchServer::FindIndexedTerm(std::string_view word) const {
+    const auto position = std::lower_bound(lexicon_.begin(), lexicon_.end(), word,
+                                           [this](TermId term_id, std::string_view value) {
+                                               return words_[term_id] < value;
+                                           });
+
+    if (position == lexicon_.end() || words_[*position] != word) {
+        return std::nullopt;
+    }
+
+    const auto [first, last] = GetPostingRange(*position);
+
+    if (first == last) {
+        return std::nullopt;
+    }
+
+    return *position;
+}
+
+std::pair<size_t, size_t> MappedSearchServer::GetPostingRange(TermId term_id) const {
+    if (term_id >= posting_ends_.size()) {
+        throw std::invalid_argument("snapshot postings are malformed"s);
+    }
+
+    const uint64_t first = term_id == 0 ? 0 : posting_ends_[term_id - 1];
+    const uint64_t last = posting_ends_[term_id];
+
+    if (last < first || last > posting_document_ids_.size()) {
+        throw std::invalid_argument("snapshot postings are malformed"s);
+    }
+
+    return {static_cast<size_t>(first), static_cast<size_t>(last)};
+}
+
+size_t MappedSearchServer::FindDocument(int document_id) const {
+    const int* position = std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+
+    if (position == document_ids_.end() || *position != document_id) {
+        return document_ids_.size();
+    }
+
+    return static_cast<size_t>(position - document_ids_.begin());
+}
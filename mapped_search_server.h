@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+#include "score_accumulator.h"
+#include "search_server.h"
+#include "search_server_snapshot.h"
+#include "top_k_selector.h"
+
+// Read-only search server answering queries straight from a memory-mapped snapshot written by
+// SearchServer::SaveSnapshot. Neither the postings nor the dictionary are copied to the heap: words are found by
+// binary search over the lexicon and posting lists are scanned in place, so opening costs a few header reads, pages
+// are brought in as queries touch them and processes mapping the same file share one page-cached copy.
+// Results are the same as of the SearchServer the snapshot was saved from
+class MappedSearchServer {
+   public:
+    using TermId = SearchServer::TermId;
+
+    // Maps the snapshot file, throws std::invalid_argument if it can not be opened or its layout is inconsistent.
+    // Checksums are not verified here, that would read the whole file, see VerifyChecksums
+    explicit MappedSearchServer(const std::string& path);
+
+    MappedSearchServer(const MappedSearchServer&) = delete;
+    MappedSearchServer& operator=(const MappedSearchServer&) = delete;
+
+    MappedSearchServer(MappedSearchServer&& other) noexcept;
+    MappedSearchServer& operator=(MappedSearchServer&& other) noexcept;
+
+    ~MappedSearchServer();
+
+   public:
+    int GetDocumentCount() const;
+
+    const int* begin() const;
+
+    const int* end() const;
+
+    // Reads every section of the file and compares it against its checksum
+    bool VerifyChecksums() const;
+
+    template <typename Predicate>
+    std::vector<Document> FindTopDocuments(
+        const std::string_view raw_query, Predicate predicate,
+        int max_result_document_count = SearchServer::kDefaultMaxResultDocumentCount) const;
+
+    std::vector<Document> FindTopDocuments(
+        const std::string_view raw_query, const DocumentStatus& desired_status = DocumentStatus::ACTUAL,
+        int max_result_document_count = SearchServer::kDefaultMaxResultDocumentCount) const;
+
+    // Returned words point into the mapping and stay valid while the server is alive
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query,
+                                                                            const int document_id) const;
+
+   private:
+    struct QueryWord {
+        TermId term_id = 0;
+        double inverse_document_frequency = 0.0;
+    };
+
+    // Words of the query found in the index, plus words ordered by posting list length
+    struct Query {
+        std::vector<QueryWord> plus_words;
+        std::vector<QueryWord> minus_words;
+    };
+
+    struct Section {
+        const char* data = nullptr;
+        search_server_snapshot::SectionHeader header{};
+    };
+
+   private:
+    // Throws std::invalid_argument if the query is malformed
+    Query ParseQuery(const std::string_view raw_query) const;
+
+    bool IsStopWord(std::string_view word) const;
+
+    // Term of a word that is in at least one document
+    std::optional<TermId> FindIndexedTerm(std::string_view word) const;
+
+    // Postings of the term are [first, last) of posting_document_ids_ and posting_term_frequencies_
+    std::pair<size_t, size_t> GetPostingRange(TermId term_id) const;
+
+    // Position of the document in document_ids_, document_ids_.size() if there is no such document
+    size_t FindDocument(int document_id) const;
+
+    void Unmap();
+
+   private:
+    const char* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+
+    std::vector<Section> sections_;
+
+    search_server_snapshot::StringsView stop_words_;
+    search_server_snapshot::StringsView words_;
+    search_server_snapshot::ArrayView<TermId> lexicon_;
+
+    search_server_snapshot::ArrayView<uint64_t> posting_ends_;
+    search_server_snapshot::ArrayView<int> posting_document_ids_;
+    search_server_snapshot::ArrayView<double> posting_term_frequencies_;
+
+    search_server_snapshot::ArrayView<int> document_ids_;
+    search_server_snapshot::ArrayView<int> ratings_;
+    search_server_snapshot::ArrayView<DocumentStatus> statuses_;
+};
+
+template <typename Predicate>
+std::vector<Document> MappedSearchServer::FindTopDocuments(const std::string_view raw_query, Predicate predicate,
+                                                           int max_result_document_count) const {
+    if (max_result_document_count < 0) {
+        throw std::invalid_argument("negative result document count is not allowed"s);
+    }
+
+    const Query query = ParseQuery(raw_query);
+
+    // scored by position in document_ids_, not by id, so the accumulator is as large as the document count however
+    // sparse the ids are. Reused by every query running on this thread
+    thread_local score_accumulation::ScoreAccumulator accumulator;
+
+    accumulator.Reset(0, static_cast<int64_t>(document_ids_.size()), document_ids_.size());
+
+    // calls action(position, index) for every posting, a posting of an unknown document can only come from a
+    // damaged file and is skipped
+    const auto for_each_posting = [this](TermId term_id, auto action) {
+        const auto [first, last] = GetPostingRange(term_id);
+
+        // ids of a list are sorted, so each one is looked for after the previous one
+        const int* document = document_ids_.begin();
+
+        for (size_t index = first; index < last; ++index) {
+            const int document_id = posting_document_ids_[index];
+            document = std::lower_bound(document, document_ids_.end(), document_id);
+
+            if (document == document_ids_.end()) {
+                return;
+            }
+
+            if (*document == document_id) {
+                action(static_cast<int>(document - document_ids_.begin()), index);
+            }
+        }
+    };
+
+    for (const auto& [term_id, inverse_document_frequency] : query.plus_words) {
+        for_each_posting(term_id, [&, inverse_document_frequency = inverse_document_frequency](int position,
+                                                                                                size_t index) {
+            accumulator.Add(position, posting_term_frequencies_[index] * inverse_document_frequency);
+        });
+    }
+
+    for (const auto& word : query.minus_words) {
+        for_each_posting(word.term_id, [&](int position, size_t) { accumulator.Exclude(position); });
+    }
+
+    top_k_selection::TopKSelector<Document, decltype(&SearchServer::IsMoreRelevant)> selector(
+        static_cast<size_t>(max_result_document_count), &SearchServer::IsMoreRelevant);
+
+    accumulator.ForEach([&](int position, double relevance) {
+        const int document_id = document_ids_[position];
+
+        if (predicate(document_id, statuses_[position], ratings_[position])) {
+            selector.Push({document_id, relevance, ratings_[position]});
+        }
+    });
+
+    return selector.ExtractSorted();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+
+// Result of matching one query against many documents: a row per document holding a bitset over the plus words of
+// the query. Rows are padded to whole 64-bit blocks, so rows filled by different threads never share a block
+class MatchedWordsTable {
+   public:
+    MatchedWordsTable() = default;
+
+    // words are the plus words of the query, bit i of a row stands for words[i]
+    MatchedWordsTable(std::vector<std::string_view> words, std::vector<int> document_ids,
+                      std::vector<DocumentStatus> statuses)
+        : words_(std::move(words)),
+          document_ids_(std::move(document_ids)),
+          statuses_(std::move(statuses)),
+          blocks_per_row_((words_.size() + kBitsPerBlock - 1) / kBitsPerBlock),
+          bits_(document_ids_.size() * blocks_per_row_, 0) {}
+
+   public:
+    size_t GetDocumentCount() const { return document_ids_.size(); }
+
+    const std::vector<std::string_view>& GetWords() const { return words_; }
+
+    int GetDocumentId(size_t row) const { return document_ids_[row]; }
+
+    const std::vector<int>& GetDocumentIds() const { return document_ids_; }
+
+    DocumentStatus GetStatus(size_t row) const { return statuses_[row]; }
+
+    bool IsMatched(size_t row, size_t word_index) const {
+        return (bits_[row * blocks_per_row_ + word_index / kBitsPerBlock] >> (word_index % kBitsPerBlock)) & 1u;
+    }
+
+    // Same words MatchDocument returns for the document of the row
+    std::vector<std::string_view> GetMatchedWords(size_t row) const {
+        std::vector<std::string_view> matched_words;
+
+        for (size_t word_index = 0; word_index < words_.size(); ++word_index) {
+            if (IsMatched(row, word_index)) {
+                matched_words.push_back(words_[word_index]);
+            }
+        }
+
+        return matched_words;
+    }
+
+    void SetMatched(size_t row, size_t word_index) {
+        bits_[row * blocks_per_row_ + word_index / kBitsPerBlock] |= uint64_t{1} << (word_index % kBitsPerBlock);
+    }
+
+    void ClearRow(size_t row) {
+        std::fill(bits_.begin() + row * blocks_per_row_, bits_.begin() + (row + 1) * blocks_per_row_, 0);
+    }
+
+   private:
+    static constexpr size_t kBitsPerBlock = 64;
+
+   private:
+    std::vector<std::string_view> words_;
+    std::vector<int> document_ids_;
+    std::vector<DocumentStatus> statuses_;
+    size_t blocks_per_row_ = 0;
+    std::vector<uint64_t> bits_;
+};
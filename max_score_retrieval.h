@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace max_score_retrieval {
+
+// Document id of an exhausted cursor, past every int id
+constexpr int64_t kEndDocumentId = std::numeric_limits<int64_t>::max();
+
+// Walks the plus words document at a time, MaxScore style: words are ordered by their score bound, and the words
+// whose bounds sum below the worst kept document can not get a document in on their own, so they are only probed for
+// documents found in the other words. Postings are bounded per block too, and a stretch of documents whose blocks can
+// not get in is skipped without scoring it.
+//
+// A Cursor walks the postings of one word and provides:
+//     int64_t GetDocumentId() const         document of the current posting, kEndDocumentId once exhausted
+//     size_t GetWordIndex() const           position of the word in the query
+//     double GetMaxScore() const            bound of the score of every posting
+//     double GetScore()                     score of the current posting
+//     bool SeekBlock(int64_t document_id)   moves to the block that may hold document_id, exhausts the cursor and
+//                                           returns false if every posting is before it
+//     double GetBlockScore() const          bounds of the block found by SeekBlock
+//     int GetBlockLastDocumentId() const
+//     void MoveTo(int64_t document_id)      moves to the first posting with a document id not below document_id
+//     void Next()                           moves past the current posting
+//
+// Documents for which is_skipped(document_id) holds are stepped over. Every other document that may get into the
+// selector is passed to collect(document_id, relevance), which pushes it if it passes the caller's filters. Relevance
+// is summed in query word order, so it is bit-identical to summing the words one after another
+template <typename Cursor, typename Selector, typename IsSkipped, typename Collect>
+void FindTopDocuments(std::vector<Cursor>& cursors, std::vector<Cursor>& minus_cursors, Selector& selector,
+                      double accuracy, IsSkipped is_skipped, Collect collect) {
+    // nothing can get into a selector of capacity 0
+    if (selector.IsFull() && selector.Size() == 0) {
+        return;
+    }
+
+    // reused by every query running on this thread
+    thread_local std::vector<double> bound_sums;
+    thread_local std::vector<std::pair<size_t, double>> matched_scores;
+
+    cursors.erase(std::remove_if(cursors.begin(), cursors.end(),
+                                 [](const Cursor& cursor) { return cursor.GetDocumentId() == kEndDocumentId; }),
+                  cursors.end());
+
+    std::sort(cursors.begin(), cursors.end(),
+              [](const Cursor& left, const Cursor& right) { return left.GetMaxScore() < right.GetMaxScore(); });
+
+    // bound_sums[i] bounds the score a document gets from the first i words
+    bound_sums.assign(1, 0.0);
+    for (const Cursor& cursor : cursors) {
+        bound_sums.push_back(bound_sums.back() + cursor.GetMaxScore());
+    }
+
+    // ties within accuracy are decided by rating, so only a bound clearly below the worst kept document prunes
+    const auto can_get_in = [&selector, accuracy](double score_bound) {
+        return !selector.IsFull() || score_bound >= selector.GetWorst().relevance - accuracy;
+    };
+
+    // words before first_essential can not get a document in on their own
+    size_t first_essential = 0;
+
+    while (true) {
+        int64_t next_document_id = kEndDocumentId;
+
+        for (size_t index = first_essential; index < cursors.size(); ++index) {
+            next_document_id = std::min(next_document_id, cursors[index].GetDocumentId());
+        }
+
+        if (next_document_id == kEndDocumentId) {
+            break;
+        }
+
+        const auto document_id = static_cast<int>(next_document_id);
+
+        // every document from the candidate to the nearest block end scores at most the blocks of the essential words
+        // around the candidate plus the other words' bounds, if that can not get in the whole stretch is skipped
+        if (selector.IsFull()) {
+            double block_bound = bound_sums[first_essential];
+            int64_t last_block_document_id = kEndDocumentId;
+
+            for (size_t index = first_essential; index < cursors.size(); ++index) {
+                Cursor& cursor = cursors[index];
+
+                if (cursor.SeekBlock(document_id)) {
+                    block_bound += cursor.GetBlockScore();
+                    last_block_document_id =
+                        std::min<int64_t>(last_block_document_id, cursor.GetBlockLastDocumentId());
+                }
+            }
+
+            if (!can_get_in(block_bound)) {
+                for (size_t index = first_essential; index < cursors.size(); ++index) {
+                    cursors[index].MoveTo(last_block_document_id + 1);
+                }
+                continue;
+            }
+        }
+
+        // a skipped document is stepped over before any other word is probed for it
+        if (is_skipped(document_id)) {
+            for (size_t index = first_essential; index < cursors.size(); ++index) {
+                if (cursors[index].GetDocumentId() == document_id) {
+                    cursors[index].Next();
+                }
+            }
+            continue;
+        }
+
+        double score = 0.0;
+        matched_scores.clear();
+
+        for (size_t index = first_essential; index < cursors.size(); ++index) {
+            Cursor& cursor = cursors[index];
+
+            if (cursor.GetDocumentId() == document_id) {
+                const double word_score = cursor.GetScore();
+                score += word_score;
+                matched_scores.emplace_back(cursor.GetWordIndex(), word_score);
+                cursor.Next();
+            }
+        }
+
+        // the other words are probed from the largest bound down, while the document can still get in
+        bool is_pruned = false;
+
+        for (size_t index = first_essential; index-- > 0;) {
+            if (!can_get_in(score + bound_sums[index + 1])) {
+                is_pruned = true;
+                break;
+            }
+
+            Cursor& cursor = cursors[index];
+
+            if (!cursor.SeekBlock(document_id)) {
+                continue;
+            }
+
+            // the block bound is tighter than the word bound
+            if (!can_get_in(score + cursor.GetBlockScore() + bound_sums[index])) {
+                is_pruned = true;
+                break;
+            }
+
+            cursor.MoveTo(document_id);
+
+            if (cursor.GetDocumentId() == document_id) {
+                const double word_score = cursor.GetScore();
+                score += word_score;
+                matched_scores.emplace_back(cursor.GetWordIndex(), word_score);
+            }
+        }
+
+        if (is_pruned || !can_get_in(score)) {
+            continue;
+        }
+
+        const bool is_excluded = std::any_of(minus_cursors.begin(), minus_cursors.end(), [document_id](Cursor& cursor) {
+            cursor.MoveTo(document_id);
+            return cursor.GetDocumentId() == document_id;
+        });
+
+        if (is_excluded) {
+            continue;
+        }
+
+        std::sort(matched_scores.begin(), matched_scores.end());
+
+        double relevance = 0.0;
+        for (const auto& [word_index, word_score] : matched_scores) {
+            relevance += word_score;
+        }
+
+        collect(document_id, relevance);
+
+        while (first_essential < cursors.size() && !can_get_in(bound_sums[first_essential + 1])) {
+            ++first_essential;
+        }
+    }
+}
+
+}  // namespace max_score_retrieval
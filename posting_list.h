@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace search_server_storage_container {
+
+// Postings of a single word: document ids and term frequencies are kept in two parallel arrays sorted by document id,
+// so scanning a word walks contiguous memory instead of chasing tree nodes. Postings are also split into blocks of
+// kBlockSize, each with its last document id and largest term frequency, so a query can bound the score of a whole
+// block and skip it without reading its postings
+class PostingList {
+   public:
+    static constexpr size_t kBlockSize = 64;
+
+    PostingList() = default;
+
+    // document_ids must be sorted and match term_frequencies one to one
+    PostingList(std::vector<int> document_ids, std::vector<double> term_frequencies)
+        : document_ids_(std::move(document_ids)), term_frequencies_(std::move(term_frequencies)) {
+        RebuildBlocks(0);
+    }
+
+    // Adds term_frequency to the posting of document_id, creating it if needed
+    void Add(int document_id, double term_frequency) {
+        // documents are usually added in increasing id order, so appending is the fast path
+        if (document_ids_.empty() || document_ids_.back() < document_id) {
+            document_ids_.push_back(document_id);
+            term_frequencies_.push_back(term_frequency);
+
+            if (document_ids_.size() % kBlockSize == 1) {
+                block_last_document_ids_.push_back(document_id);
+                block_max_term_frequencies_.push_back(term_frequency);
+            } else {
+                block_last_document_ids_.back() = document_id;
+                block_max_term_frequencies_.back() = std::max(block_max_term_frequencies_.back(), term_frequency);
+            }
+
+            max_term_frequency_ = std::max(max_term_frequency_, term_frequency);
+            return;
+        }
+
+        const auto position = LowerBound(document_id);
+        const auto index = static_cast<size_t>(position - document_ids_.begin());
+
+        if (position != document_ids_.end() && *position == document_id) {
+            term_frequencies_[index] += term_frequency;
+
+            double& block_max_term_frequency = block_max_term_frequencies_[index / kBlockSize];
+            block_max_term_frequency = std::max(block_max_term_frequency, term_frequencies_[index]);
+            max_term_frequency_ = std::max(max_term_frequency_, term_frequencies_[index]);
+            return;
+        }
+
+        document_ids_.insert(position, document_id);
+        term_frequencies_.insert(term_frequencies_.begin() + index, term_frequency);
+
+        // every later posting moved one place, and with it the block boundaries
+        RebuildBlocks(index / kBlockSize);
+    }
+
+    // Merges postings of documents that are not in the list yet, document_ids must be sorted
+    void Merge(const int* document_ids, const double* term_frequencies, size_t count) {
+        if (count == 0) {
+            return;
+        }
+
+        if (document_ids_.empty() || document_ids_.back() < document_ids[0]) {
+            const size_t first_block = document_ids_.size() / kBlockSize;
+
+            document_ids_.insert(document_ids_.end(), document_ids, document_ids + count);
+            term_frequencies_.insert(term_frequencies_.end(), term_frequencies, term_frequencies + count);
+
+            RebuildBlocks(first_block);
+            return;
+        }
+
+        std::vector<int> merged_document_ids;
+        std::vector<double> merged_term_frequencies;
+        merged_document_ids.reserve(document_ids_.size() + count);
+        merged_term_frequencies.reserve(document_ids_.size() + count);
+
+        size_t old_index = 0;
+        size_t new_index = 0;
+
+        while (old_index < document_ids_.size() || new_index < count) {
+            if (new_index == count ||
+                (old_index < document_ids_.size() && document_ids_[old_index] < document_ids[new_index])) {
+                merged_document_ids.push_back(document_ids_[old_index]);
+                merged_term_frequencies.push_back(term_frequencies_[old_index]);
+                ++old_index;
+            } else {
+                merged_document_ids.push_back(document_ids[new_index]);
+                merged_term_frequencies.push_back(term_frequencies[new_index]);
+                ++new_index;
+            }
+        }
+
+        document_ids_ = std::move(merged_document_ids);
+        term_frequencies_ = std::move(merged_term_frequencies);
+
+        RebuildBlocks(0);
+    }
+
+    bool Remove(int document_id) {
+        const auto position = LowerBound(document_id);
+
+        if (position == document_ids_.end() || *position != document_id) {
+            return false;
+        }
+
+        const auto index = static_cast<size_t>(position - document_ids_.begin());
+        document_ids_.erase(position);
+        term_frequencies_.erase(term_frequencies_.begin() + index);
+
+        RebuildBlocks(index / kBlockSize);
+
+        return true;
+    }
+
+    bool Contains(int document_id) const { return std::binary_search(document_ids_.begin(), document_ids_.end(), document_id); }
+
+    size_t Size() const { return document_ids_.size(); }
+
+    bool IsEmpty() const { return document_ids_.empty(); }
+
+    const std::vector<int>& GetDocumentIds() const { return document_ids_; }
+
+    const std::vector<double>& GetTermFrequencies() const { return term_frequencies_; }
+
+    // Largest term frequency in the list
+    double GetMaxTermFrequency() const { return max_term_frequency_; }
+
+    // Block b holds the postings [b * kBlockSize, (b + 1) * kBlockSize)
+    const std::vector<int>& GetBlockLastDocumentIds() const { return block_last_document_ids_; }
+
+    const std::vector<double>& GetBlockMaxTermFrequencies() const { return block_max_term_frequencies_; }
+
+   private:
+    std::vector<int>::iterator LowerBound(int document_id) {
+        return std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+    }
+
+    // Recomputes the blocks from first_block on, and the largest term frequency from the blocks
+    void RebuildBlocks(size_t first_block) {
+        const size_t block_count = (document_ids_.size() + kBlockSize - 1) / kBlockSize;
+
+        block_last_document_ids_.resize(block_count);
+        block_max_term_frequencies_.resize(block_count);
+
+        for (size_t block = first_block; block < block_count; ++block) {
+            const size_t first = block * kBlockSize;
+            const size_t last = std::min(first + kBlockSize, document_ids_.size());
+
+            block_last_document_ids_[block] = document_ids_[last - 1];
+            block_max_term_frequencies_[block] =
+                *std::max_element(term_frequencies_.begin() + first, term_frequencies_.begin() + last);
+        }
+
+        max_term_frequency_ = block_count == 0 ? 0.0
+                                               : *std::max_element(block_max_term_frequencies_.begin(),
+                                                                   block_max_term_frequencies_.end());
+    }
+
+   private:
+    std::vector<int> document_ids_;
+    std::vector<double> term_frequencies_;
+
+    std::vector<int> block_last_document_ids_;
+    std::vector<double> block_max_term_frequencies_;
+    double max_term_frequency_ = 0.0;
+};
+
+}  // namespace search_server_storage_container
@@ -1,6 +1,8 @@
-#include <execution>
+#include "process_queries.h"
 
-#include "search_server.h"
+#include <algorithm>
+#include <execution>
+#include <numeric>
 
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
                                                   const std::vector<std::string>& queries) {
@@ -13,13 +15,41 @@ std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_ser
     return output;
 }
 
-std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries) {
-    const auto documents = ProcessQueries(search_server, queries);
+QueryResults ProcessQueriesFlattened(const SearchServer& search_server, const std::vector<std::string>& queries) {
+    constexpr auto kMaxCount = static_cast<size_t>(SearchServer::kDefaultMaxResultDocumentCount);
+
+    // query i copies its results to [i * kMaxCount, i * kMaxCount + counts[i]), the buffer is compacted afterwards
+    std::vector<Document> documents(queries.size() * kMaxCount);
+    std::vector<size_t> counts(queries.size());
+
+    std::vector<size_t> query_indexes(queries.size());
+    std::iota(query_indexes.begin(), query_indexes.end(), 0);
+
+    std::for_each(std::execution::par, query_indexes.begin(), query_indexes.end(), [&](size_t query) {
+        const std::vector<Document> results = search_server.FindTopDocuments(queries[query]);
+        std::copy(results.begin(), results.end(), documents.begin() + query * kMaxCount);
+        counts[query] = results.size();
+    });
 
-    const auto func = [](std::vector<Document> first, std::vector<Document> second) {
-        first.insert(first.end(), second.begin(), second.end());
-        return first;
-    };
+    std::vector<size_t> offsets(queries.size() + 1, 0);
+    std::inclusive_scan(counts.begin(), counts.end(), offsets.begin() + 1);
 
-    return std::reduce(std::execution::par, documents.begin(), documents.end(), std::vector<Document>{}, func);
+    // a query never moves right, so the slices are moved in query order within the buffer. A slice that is already
+    // in place is left alone, std::copy must not write to the start of its own input
+    for (size_t query = 0; query < queries.size(); ++query) {
+        if (offsets[query] == query * kMaxCount) {
+            continue;
+        }
+
+        const auto slot = documents.begin() + query * kMaxCount;
+        std::copy(slot, slot + counts[query], documents.begin() + offsets[query]);
+    }
+
+    documents.resize(offsets.back());
+
+    return {std::move(documents), std::move(offsets)};
+}
+
+std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries) {
+    return ProcessQueriesFlattened(search_server, queries).ExtractDocuments();
 }
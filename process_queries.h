@@ -1,13 +1,124 @@
 #pragma once
 
+#include <cstddef>
 #include <execution>
+#include <iterator>
 #include <numeric>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "paginator.h"
 #include "search_server.h"
 
+// Results of many queries in one contiguous buffer, the results of a query follow the results of the previous one
+class QueryResults {
+   public:
+    using Iterator = std::vector<Document>::const_iterator;
+
+    QueryResults() = default;
+
+    // offsets has a query more than there are queries: results of query i are [offsets[i], offsets[i + 1])
+    QueryResults(std::vector<Document> documents, std::vector<size_t> offsets)
+        : documents_(std::move(documents)), offsets_(std::move(offsets)) {}
+
+   public:
+    size_t GetQueryCount() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+
+    IteratorRange<Iterator> GetDocuments(size_t query) const {
+        return {documents_.begin() + offsets_[query], documents_.begin() + offsets_[query + 1]};
+    }
+
+    // documents of all queries in query order
+    Iterator begin() const { return documents_.begin(); }
+
+    Iterator end() const { return documents_.end(); }
+
+    size_t size() const { return documents_.size(); }
+
+    // Leaves the results empty
+    std::vector<Document> ExtractDocuments() {
+        offsets_.clear();
+        return std::move(documents_);
+    }
+
+   private:
+    std::vector<Document> documents_;
+    std::vector<size_t> offsets_;
+};
+
+// Documents of per-query results in query order, read where they are without joining them
+class JoinedDocumentsView {
+   public:
+    class Iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Document;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Document*;
+        using reference = const Document&;
+
+        Iterator() = default;
+
+        Iterator(const std::vector<std::vector<Document>>* results, size_t query, size_t position)
+            : results_(results), query_(query), position_(position) {
+            SkipEmptyQueries();
+        }
+
+        reference operator*() const { return (*results_)[query_][position_]; }
+
+        pointer operator->() const { return &(*results_)[query_][position_]; }
+
+        Iterator& operator++() {
+            ++position_;
+            SkipEmptyQueries();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const { return query_ == other.query_ && position_ == other.position_; }
+
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+       private:
+        // stops at a document or at the end, which is position 0 past the last query
+        void SkipEmptyQueries() {
+            while (query_ < results_->size() && position_ == (*results_)[query_].size()) {
+                ++query_;
+                position_ = 0;
+            }
+        }
+
+       private:
+        const std::vector<std::vector<Document>>* results_ = nullptr;
+        size_t query_ = 0;
+        size_t position_ = 0;
+    };
+
+    // results must outlive the view
+    explicit JoinedDocumentsView(const std::vector<std::vector<Document>>& results) : results_(&results) {}
+
+   public:
+    Iterator begin() const { return {results_, 0, 0}; }
+
+    Iterator end() const { return {results_, results_->size(), 0}; }
+
+    bool empty() const { return begin() == end(); }
+
+   private:
+    const std::vector<std::vector<Document>>* results_ = nullptr;
+};
+
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
                                                   const std::vector<std::string>& queries);
 
+// Every query copies its results into a slot of one buffer as soon as it is answered, the slots are then compacted
+// in place by a prefix sum of the counts
+QueryResults ProcessQueriesFlattened(const SearchServer& search_server, const std::vector<std::string>& queries);
+
 std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries);
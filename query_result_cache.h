@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+
+namespace query_result_caching {
+
+// Size-bounded LRU map from normalized queries to their results, split into shards with a lock each, so concurrent
+// queries rarely wait for one another. Like InverseDocumentFrequencyCache it is invalidated by bumping a generation:
+// entries of an older generation are misses and are dropped when met or evicted. Lookups and insertions are safe to
+// run concurrently, SetCapacity and copying need exclusive access
+class QueryResultCache {
+   public:
+    struct Statistics {
+        uint64_t hit_count = 0;
+        uint64_t miss_count = 0;
+    };
+
+    QueryResultCache() = default;
+
+    // copies the capacity only, entries and counters start empty
+    QueryResultCache(const QueryResultCache& other) { SetCapacity(other.capacity_); }
+
+    QueryResultCache& operator=(const QueryResultCache& other) {
+        if (this != &other) {
+            SetCapacity(other.capacity_);
+        }
+        return *this;
+    }
+
+    // 0 turns the cache off. Drops every entry
+    void SetCapacity(size_t capacity) {
+        capacity_ = capacity;
+
+        const size_t shard_count = std::min(kMaxShardCount, capacity);
+        shards_ = std::vector<Shard>(shard_count);
+
+        for (size_t shard = 0; shard < shard_count; ++shard) {
+            shards_[shard].capacity = capacity / shard_count + (shard < capacity % shard_count ? 1 : 0);
+        }
+    }
+
+    bool IsEnabled() const { return capacity_ > 0; }
+
+    // Every entry is stale from now on
+    void Invalidate() { generation_.fetch_add(1, std::memory_order_acq_rel); }
+
+    // Results cached for the key in the current generation, counted as a hit or a miss
+    std::optional<std::vector<Document>> Find(const std::string& key) const {
+        const uint64_t generation = generation_.load(std::memory_order_acquire);
+        Shard& shard = GetShard(key);
+
+        {
+            std::lock_guard guard(shard.mutex);
+
+            if (const auto it = shard.positions.find(key); it != shard.positions.end()) {
+                if (it->second->generation == generation) {
+                    // most recently used entries are at the front
+                    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+                    hit_count_.fetch_add(1, std::memory_order_relaxed);
+                    return it->second->documents;
+                }
+
+                shard.entries.erase(it->second);
+                shard.positions.erase(it);
+            }
+        }
+
+        miss_count_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    // generation is the one read by GetGeneration before the results were computed, so results of a query that ran
+    // across an invalidation are never cached as current
+    void Insert(const std::string& key, std::vector<Document> documents, uint64_t generation) const {
+        if (generation != generation_.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        Shard& shard = GetShard(key);
+        std::lock_guard guard(shard.mutex);
+
+        if (const auto it = shard.positions.find(key); it != shard.positions.end()) {
+            shard.entries.erase(it->second);
+            shard.positions.erase(it);
+        }
+
+        if (shard.entries.size() == shard.capacity) {
+            shard.positions.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+        }
+
+        shard.entries.push_front({key, std::move(documents), generation});
+        shard.positions.emplace(key, shard.entries.begin());
+    }
+
+    uint64_t GetGeneration() const { return generation_.load(std::memory_order_acquire); }
+
+    Statistics GetStatistics() const {
+        return {hit_count_.load(std::memory_order_relaxed), miss_count_.load(std::memory_order_relaxed)};
+    }
+
+   private:
+    static constexpr size_t kMaxShardCount = 16;
+
+    struct Entry {
+        std::string key;
+        std::vector<Document> documents;
+        uint64_t generation = 0;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        size_t capacity = 0;
+        std::list<Entry> entries;
+        std::unordered_map<std::string, std::list<Entry>::iterator> positions;
+    };
+
+   private:
+    Shard& GetShard(const std::string& key) const { return shards_[std::hash<std::string>{}(key) % shards_.size()]; }
+
+   private:
+    size_t capacity_ = 0;
+    mutable std::vector<Shard> shards_;
+
+    std::atomic<uint64_t> generation_ = 1;
+    mutable std::atomic<uint64_t> hit_count_ = 0;
+    mutable std::atomic<uint64_t> miss_count_ = 0;
+};
+
+}  // namespace query_result_caching
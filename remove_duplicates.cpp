@@ -1,37 +1,240 @@
 #include "remove_duplicates.h"
 
-#include <iostream>
-#include <set>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 #include <string>
-#include <vector>
+#include <unordered_map>
 
 using namespace std::literals;
 
 namespace remove_duplicates {
 
-void RemoveDuplicates(SearchServer& search_server) {
-    std::set<std::set<std::string>> unique_documents;
+namespace {
+
+// Finalizer of splitmix64: every input bit flips about half of the output bits
+uint64_t Mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+struct FingerprintHasher {
+    // the low half is already well mixed
+    size_t operator()(const Fingerprint& fingerprint) const { return static_cast<size_t>(fingerprint.low); }
+};
+
+bool HaveSameWords(const std::vector<SearchServer::TermFrequency>& left,
+                   const std::vector<SearchServer::TermFrequency>& right) {
+    return std::equal(left.begin(), left.end(), right.begin(), right.end(),
+                      [](const auto& left_word, const auto& right_word) {
+                          return left_word.term_id == right_word.term_id;
+                      });
+}
+
+// Probability that a pair of the given similarity agrees on a whole band in at least one of the bands
+double GetCandidateProbability(double similarity, size_t row_count) {
+    const double band_count = static_cast<double>(kSignatureSize / row_count);
+    return 1.0 - std::pow(1.0 - std::pow(similarity, static_cast<double>(row_count)), band_count);
+}
+
+size_t FindRoot(std::vector<uint32_t>& parents, uint32_t position) {
+    while (parents[position] != position) {
+        // path halving
+        parents[position] = parents[parents[position]];
+        position = parents[position];
+    }
+    return position;
+}
+
+}  // namespace
+
+Fingerprint ComputeFingerprint(const std::vector<SearchServer::TermFrequency>& term_frequencies) {
+    // two chains with different seeds, each step depends on the whole prefix, so the order of ids counts
+    Fingerprint fingerprint{0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL};
+
+    for (const auto& [term_id, frequency] : term_frequencies) {
+        fingerprint.high = Mix(fingerprint.high ^ term_id);
+        fingerprint.low = Mix(fingerprint.low + term_id);
+    }
+
+    fingerprint.high = Mix(fingerprint.high ^ term_frequencies.size());
+    fingerprint.low = Mix(fingerprint.low + term_frequencies.size());
+
+    return fingerprint;
+}
+
+std::vector<int> CollectDuplicates(const SearchServer& search_server, const std::vector<int>& document_ids,
+                                   const std::vector<Fingerprint>& fingerprints) {
+    // fingerprint to the position of a kept document, several positions only after a collision
+    std::unordered_multimap<Fingerprint, size_t, FingerprintHasher> kept_documents;
+    kept_documents.reserve(document_ids.size());
 
     std::vector<int> duplicate_document_ids;
 
-    for (const int document_id : search_server) {
-        const auto words_to_term_frequencies = search_server.GetWordFrequencies(document_id);
+    for (size_t position = 0; position < document_ids.size(); ++position) {
+        const auto& term_frequencies = search_server.GetTermFrequencies(document_ids[position]);
+        const auto [first, last] = kept_documents.equal_range(fingerprints[position]);
+
+        const bool is_duplicate = std::any_of(first, last, [&](const auto& kept_document) {
+            return HaveSameWords(search_server.GetTermFrequencies(document_ids[kept_document.second]),
+                                 term_frequencies);
+        });
+
+        if (is_duplicate) {
+            duplicate_document_ids.push_back(document_ids[position]);
+        } else {
+            kept_documents.emplace(fingerprints[position], position);
+        }
+    }
+
+    return duplicate_document_ids;
+}
+
+std::vector<int> FindDuplicates(const SearchServer& search_server) {
+    return FindDuplicates(std::execution::seq, search_server);
+}
+
+std::vector<int> RemoveDuplicates(SearchServer& search_server) {
+    return RemoveDuplicates(std::execution::seq, search_server);
+}
+
+size_t GetBandRowCount(double similarity_threshold) {
+    if (!(similarity_threshold > 0.0 && similarity_threshold <= 1.0)) {
+        throw std::invalid_argument("similarity threshold must be in (0, 1]"s);
+    }
+
+    constexpr double kMinCandidateProbability = 0.9;
+
+    // more rows make fewer dissimilar candidates but miss more similar pairs
+    size_t row_count = 1;
+    while (row_count < kSignatureSize &&
+           GetCandidateProbability(similarity_threshold, row_count + 1) >= kMinCandidateProbability) {
+        ++row_count;
+    }
+
+    return row_count;
+}
+
+void ComputeSignature(const std::vector<SearchServer::TermFrequency>& term_frequencies, uint32_t* signature) {
+    std::fill(signature, signature + kSignatureSize, std::numeric_limits<uint32_t>::max());
 
-        std::set<std::string> words_in_document;
+    // hash function index maps a term to its hash plus index steps, both drawn from the term id. The steps are added
+    // one by one, which keeps the loop free of 64-bit multiplications and lets it vectorize
+    for (const auto& [term_id, frequency] : term_frequencies) {
+        const uint64_t step = Mix(term_id ^ 0x9e3779b97f4a7c15ULL) | 1;
+        uint64_t hash = Mix(term_id);
 
-        for (const auto& [word, term_frequency] : words_to_term_frequencies) {
-            words_in_document.emplace(word);
+        for (size_t index = 0; index < kSignatureSize; ++index) {
+            signature[index] = std::min(signature[index], static_cast<uint32_t>(hash >> 32));
+            hash += step;
         }
+    }
+}
+
+void CollectBandCandidates(const std::vector<uint32_t>& signatures, size_t band, size_t row_count,
+                           std::vector<std::pair<uint32_t, uint32_t>>& candidate_pairs) {
+    const size_t document_count = signatures.size() / kSignatureSize;
+
+    // documents with equal keys agree on the band, unless the keys collide, which only adds a candidate
+    std::vector<std::pair<uint64_t, uint32_t>> keys(document_count);
+
+    for (size_t position = 0; position < document_count; ++position) {
+        const uint32_t* rows = signatures.data() + position * kSignatureSize + band * row_count;
+
+        uint64_t key = 0;
+        for (size_t row = 0; row < row_count; ++row) {
+            key = Mix(key + rows[row]);
+        }
+
+        keys[position] = {key, static_cast<uint32_t>(position)};
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    for (size_t bucket_first = 0, index = 0; index < keys.size(); ++index) {
+        if (keys[index].first != keys[bucket_first].first) {
+            bucket_first = index;
+        }
+
+        for (size_t other = index - std::min(index - bucket_first, kBucketWindow); other < index; ++other) {
+            candidate_pairs.emplace_back(keys[other].second, keys[index].second);
+        }
+    }
+}
+
+double ComputeSimilarity(const std::vector<SearchServer::TermFrequency>& left,
+                         const std::vector<SearchServer::TermFrequency>& right) {
+    if (left.empty() && right.empty()) {
+        return 1.0;
+    }
 
-        if (!unique_documents.insert(words_in_document).second) {
-            duplicate_document_ids.push_back(document_id);
-            std::cout << "Found duplicate document id "s << document_id << std::endl;
+    // both are sorted by term id
+    size_t common_count = 0;
+    for (auto left_it = left.begin(), right_it = right.begin(); left_it != left.end() && right_it != right.end();) {
+        if (left_it->term_id < right_it->term_id) {
+            ++left_it;
+        } else if (right_it->term_id < left_it->term_id) {
+            ++right_it;
+        } else {
+            ++common_count;
+            ++left_it;
+            ++right_it;
         }
     }
 
-    for (const int duplicate_id : duplicate_document_ids) {
-        search_server.RemoveDocument(duplicate_id);
+    return static_cast<double>(common_count) / static_cast<double>(left.size() + right.size() - common_count);
+}
+
+std::vector<std::vector<int>> CollectClusters(const std::vector<int>& document_ids,
+                                              const std::vector<std::pair<uint32_t, uint32_t>>& candidate_pairs,
+                                              const std::vector<char>& is_similar) {
+    std::vector<uint32_t> parents(document_ids.size());
+    std::iota(parents.begin(), parents.end(), 0);
+
+    for (size_t index = 0; index < candidate_pairs.size(); ++index) {
+        if (is_similar[index]) {
+            const size_t first_root = FindRoot(parents, candidate_pairs[index].first);
+            const size_t second_root = FindRoot(parents, candidate_pairs[index].second);
+
+            // the smaller position stays the root, so a root is the first document of its cluster
+            parents[std::max(first_root, second_root)] = static_cast<uint32_t>(std::min(first_root, second_root));
+        }
+    }
+
+    std::vector<size_t> cluster_sizes(document_ids.size(), 0);
+    for (uint32_t position = 0; position < document_ids.size(); ++position) {
+        ++cluster_sizes[FindRoot(parents, position)];
+    }
+
+    // cluster of every root with more than one document, in order of the roots
+    std::vector<size_t> cluster_indexes(document_ids.size(), 0);
+    std::vector<std::vector<int>> clusters;
+
+    for (uint32_t position = 0; position < document_ids.size(); ++position) {
+        const size_t root = FindRoot(parents, position);
+
+        if (cluster_sizes[root] < 2) {
+            continue;
+        }
+
+        if (root == position) {
+            cluster_indexes[root] = clusters.size();
+            clusters.emplace_back();
+            clusters.back().reserve(cluster_sizes[root]);
+        }
+
+        clusters[cluster_indexes[root]].push_back(document_ids[position]);
     }
+
+    return clusters;
+}
+
+std::vector<std::vector<int>> FindNearDuplicates(const SearchServer& search_server, double similarity_threshold) {
+    return FindNearDuplicates(std::execution::seq, search_server, similarity_threshold);
 }
 
 }  // namespace remove_duplicates
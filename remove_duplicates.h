@@ -1,9 +1,154 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <numeric>
+#include <utility>
+#include <vector>
+
 #include "search_server.h"
 
 namespace remove_duplicates {
 
-void RemoveDuplicates(SearchServer& search_server);
+// 128-bit hash of the sorted term ids of a document: documents with the same set of words get the same fingerprint,
+// and different sets practically never do
+struct Fingerprint {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    bool operator==(const Fingerprint& other) const { return high == other.high && low == other.low; }
+};
+
+Fingerprint ComputeFingerprint(const std::vector<SearchServer::TermFrequency>& term_frequencies);
+
+// Ids of documents with the same set of words as a document with a smaller id, in increasing order. fingerprints
+// are of document_ids, which are in increasing order. Documents with equal fingerprints are compared word by word,
+// so a collision can not make documents duplicates
+std::vector<int> CollectDuplicates(const SearchServer& search_server, const std::vector<int>& document_ids,
+                                   const std::vector<Fingerprint>& fingerprints);
+
+// Fingerprints are computed concurrently under a parallel policy, duplicates are found with a hash table in time
+// linear in the number of words of the documents
+template <typename ExecutionPolicy>
+std::vector<int> FindDuplicates(const ExecutionPolicy& policy, const SearchServer& search_server) {
+    const std::vector<int> document_ids(search_server.begin(), search_server.end());
+
+    std::vector<Fingerprint> fingerprints(document_ids.size());
+    std::transform(policy, document_ids.begin(), document_ids.end(), fingerprints.begin(),
+                   [&search_server](int document_id) {
+                       return ComputeFingerprint(search_server.GetTermFrequencies(document_id));
+                   });
+
+    return CollectDuplicates(search_server, document_ids, fingerprints);
+}
+
+std::vector<int> FindDuplicates(const SearchServer& search_server);
+
+// Removes the documents FindDuplicates finds and returns their ids
+template <typename ExecutionPolicy>
+std::vector<int> RemoveDuplicates(const ExecutionPolicy& policy, SearchServer& search_server) {
+    std::vector<int> duplicate_document_ids = FindDuplicates(policy, search_server);
+
+    for (const int document_id : duplicate_document_ids) {
+        search_server.RemoveDocument(document_id);
+    }
+
+    return duplicate_document_ids;
+}
+
+std::vector<int> RemoveDuplicates(SearchServer& search_server);
+
+// Near duplicates: documents whose word sets have Jaccard similarity of at least a threshold. Every document gets a
+// MinHash signature, signatures are cut into LSH bands, and only documents agreeing on a whole band are compared, so
+// candidates are found without comparing all pairs. Candidates are checked on their words, so a cluster holds no
+// document that is not similar enough to another one of it, but a similar pair may be missed with small probability
+
+constexpr double kDefaultSimilarityThreshold = 0.8;
+
+// MinHash values per document
+constexpr size_t kSignatureSize = 128;
 
+// A document is compared with at most this many documents that came before it in an LSH bucket, which keeps buckets
+// of many copies of a page from costing quadratic time
+constexpr size_t kBucketWindow = 32;
+
+// Rows per band: the most that make a pair exactly at the threshold a candidate with probability of at least 0.9.
+// Throws std::invalid_argument if the threshold is not in (0, 1]
+size_t GetBandRowCount(double similarity_threshold);
+
+// Writes the kSignatureSize MinHash values of the term ids to signature
+void ComputeSignature(const std::vector<SearchServer::TermFrequency>& term_frequencies, uint32_t* signature);
+
+// Appends pairs of positions, smaller first, of signatures that are equal in the band. signatures are
+// kSignatureSize values per document
+void CollectBandCandidates(const std::vector<uint32_t>& signatures, size_t band, size_t row_count,
+                           std::vector<std::pair<uint32_t, uint32_t>>& candidate_pairs);
+
+// Jaccard similarity of the words of two documents
+double ComputeSimilarity(const std::vector<SearchServer::TermFrequency>& left,
+                         const std::vector<SearchServer::TermFrequency>& right);
+
+// Connected components of the similar pairs, as ids of documents at those positions. Components of one document
+// are dropped, ids in a cluster and clusters by their first id are in increasing order
+std::vector<std::vector<int>> CollectClusters(const std::vector<int>& document_ids,
+                                              const std::vector<std::pair<uint32_t, uint32_t>>& candidate_pairs,
+                                              const std::vector<char>& is_similar);
+
+// Signatures, bands and candidate checks are computed concurrently under a parallel policy. Documents without
+// words are left out. Throws std::invalid_argument if the threshold is not in (0, 1]
+template <typename ExecutionPolicy>
+std::vector<std::vector<int>> FindNearDuplicates(const ExecutionPolicy& policy, const SearchServer& search_server,
+                                                 double similarity_threshold = kDefaultSimilarityThreshold) {
+    const size_t row_count = GetBandRowCount(similarity_threshold);
+    const size_t band_count = kSignatureSize / row_count;
+
+    std::vector<int> document_ids;
+    for (const int document_id : search_server) {
+        if (!search_server.GetTermFrequencies(document_id).empty()) {
+            document_ids.push_back(document_id);
+        }
+    }
+
+    std::vector<size_t> positions(document_ids.size());
+    std::iota(positions.begin(), positions.end(), 0);
+
+    std::vector<uint32_t> signatures(document_ids.size() * kSignatureSize);
+    std::for_each(policy, positions.begin(), positions.end(), [&](size_t position) {
+        ComputeSignature(search_server.GetTermFrequencies(document_ids[position]),
+                         signatures.data() + position * kSignatureSize);
+    });
+
+    // every band is bucketed by exactly one task
+    std::vector<size_t> bands(band_count);
+    std::iota(bands.begin(), bands.end(), 0);
+
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> band_candidate_pairs(band_count);
+    std::for_each(policy, bands.begin(), bands.end(), [&](size_t band) {
+        CollectBandCandidates(signatures, band, row_count, band_candidate_pairs[band]);
+    });
+
+    std::vector<std::pair<uint32_t, uint32_t>> candidate_pairs;
+    for (const auto& pairs : band_candidate_pairs) {
+        candidate_pairs.insert(candidate_pairs.end(), pairs.begin(), pairs.end());
+    }
+
+    // a pair found in several bands is checked once
+    std::sort(policy, candidate_pairs.begin(), candidate_pairs.end());
+    candidate_pairs.erase(std::unique(candidate_pairs.begin(), candidate_pairs.end()), candidate_pairs.end());
+
+    std::vector<char> is_similar(candidate_pairs.size());
+    std::transform(policy, candidate_pairs.begin(), candidate_pairs.end(), is_similar.begin(),
+                   [&](const std::pair<uint32_t, uint32_t>& candidate_pair) {
+                       return ComputeSimilarity(search_server.GetTermFrequencies(document_ids[candidate_pair.first]),
+                                                search_server.GetTermFrequencies(
+                                                    document_ids[candidate_pair.second])) >= similarity_threshold;
+                   });
+
+    return CollectClusters(document_ids, candidate_pairs, is_similar);
 }
+
+std::vector<std::vector<int>> FindNearDuplicates(const SearchServer& search_server,
+                                                 double similarity_threshold = kDefaultSimilarityThreshold);
+
+}  // namespace remove_duplicates
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace score_accumulation {
+
+// Relevance accumulator over a range of document ids. While the range is not much wider than the number of documents
+// it is a dense array: instead of clearing the whole array between queries, every slot is stamped with the generation
+// of the query that last touched it, so Reset is O(1) and an instance is meant to be reused across queries (one per
+// thread). Ids may be arbitrarily sparse, so a range too wide for the documents in it is accumulated in a hash table
+class ScoreAccumulator {
+   public:
+    // Ranges up to this wide are dense whatever the document count
+    static constexpr size_t kMinDenseRangeSize = size_t{1} << 16;
+
+    // Dense slots allowed per document, beyond that the range is sparse
+    static constexpr size_t kMaxDenseSlotsPerDocument = 8;
+
+    // Prepares the accumulator for a query over document ids [first_document_id, last_document_id), document_count
+    // bounds the number of documents in the range
+    void Reset(int64_t first_document_id, int64_t last_document_id, size_t document_count) {
+        const auto size = static_cast<size_t>(std::max<int64_t>(0, last_document_id - first_document_id));
+
+        first_document_id_ = first_document_id;
+
+        touched_document_ids_.clear();
+
+        is_dense_ = size <= std::max(kMinDenseRangeSize, kMaxDenseSlotsPerDocument * document_count);
+
+        if (!is_dense_) {
+            sparse_slots_.clear();
+            return;
+        }
+
+        if (scores_.size() < size) {
+            scores_.resize(size);
+            score_generations_.resize(size, 0);
+            exclusion_generations_.resize(size, 0);
+        }
+
+        if (++generation_ == 0) {
+            // stamps from 2^32 queries ago would look fresh again
+            std::fill(score_generations_.begin(), score_generations_.end(), 0);
+            std::fill(exclusion_generations_.begin(), exclusion_generations_.end(), 0);
+            generation_ = 1;
+        }
+    }
+
+    void Add(int document_id, double score) {
+        if (!is_dense_) {
+            SparseSlot& slot = sparse_slots_[document_id];
+
+            if (!slot.is_scored) {
+                slot.is_scored = true;
+                slot.score = score;
+                touched_document_ids_.push_back(document_id);
+            } else {
+                slot.score += score;
+            }
+            return;
+        }
+
+        const auto index = static_cast<size_t>(document_id - first_document_id_);
+
+        if (score_generations_[index] != generation_) {
+            score_generations_[index] = generation_;
+            scores_[index] = score;
+            touched_document_ids_.push_back(document_id);
+        } else {
+            scores_[index] += score;
+        }
+    }
+
+    // An excluded document is skipped by ForEach whatever its score is
+    void Exclude(int document_id) {
+        if (!is_dense_) {
+            sparse_slots_[document_id].is_excluded = true;
+            return;
+        }
+
+        exclusion_generations_[static_cast<size_t>(document_id - first_document_id_)] = generation_;
+    }
+
+    // Calls action(document_id, relevance) for every scored and not excluded document
+    template <typename Action>
+    void ForEach(Action action) const {
+        for (const int document_id : touched_document_ids_) {
+            if (!is_dense_) {
+                const SparseSlot& slot = sparse_slots_.at(document_id);
+
+                if (!slot.is_excluded) {
+                    action(document_id, slot.score);
+                }
+                continue;
+            }
+
+            const auto index = static_cast<size_t>(document_id - first_document_id_);
+
+            if (exclusion_generations_[index] != generation_) {
+                action(document_id, scores_[index]);
+            }
+        }
+    }
+
+   private:
+    struct SparseSlot {
+        double score = 0.0;
+        bool is_scored = false;
+        bool is_excluded = false;
+    };
+
+   private:
+    std::vector<double> scores_;
+    std::vector<uint32_t> score_generations_;
+    std::vector<uint32_t> exclusion_generations_;
+    std::unordered_map<int, SparseSlot> sparse_slots_;
+    std::vector<int> touched_document_ids_;
+    int64_t first_document_id_ = 0;
+    uint32_t generation_ = 0;
+    bool is_dense_ = true;
+};
+
+}  // namespace score_accumulation
@@ -16,18 +16,50 @@ std::set<int>::const_iterator SearchServer::begin() const { return document_ids_
 
 std::set<int>::const_iterator SearchServer::end() const { return document_ids_.end(); }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    const static std::map<std::string_view, double> empty_map;
+std::map<std::string_view, double> SearchServer::GetWordFrequencies(int document_id) const {
+    std::map<std::string_view, double> word_frequencies;
 
-    if (document_id_to_document_data_.count(document_id) > 0) {
-        return document_id_to_document_data_.at(document_id).word_frequencies;
+    for (const auto& [term_id, frequency] : GetTermFrequencies(document_id)) {
+        word_frequencies.emplace(words_storage_.GetWord(term_id), frequency);
+    }
+
+    return word_frequencies;
+}
+
+const std::vector<SearchServer::TermFrequency>& SearchServer::GetTermFrequencies(int document_id) const {
+    const static std::vector<TermFrequency> empty_frequencies;
+
+    if (const auto it = document_id_to_document_data_.find(document_id); it != document_id_to_document_data_.end()) {
+        return it->second.term_frequencies;
     }
 
-    return empty_map;
+    return empty_frequencies;
+}
+
+std::string_view SearchServer::GetWord(TermId term_id) const { return words_storage_.GetWord(term_id); }
+
+std::optional<double> SearchServer::GetInverseDocumentFrequency(std::string_view word) const {
+    const auto term_id = words_storage_.Find(word);
+
+    if (!term_id || GetDocumentFrequency(*term_id) == 0) {
+        return std::nullopt;
+    }
+
+    return GetWordInverseDocumentFrequency(*term_id);
 }
 
 void SearchServer::RemoveDocument(const int document_id) { RemoveDocument(std::execution::seq, document_id); }
 
+void SearchServer::Compact() { Compact(std::execution::seq); }
+
+void SearchServer::SetCompactionThreshold(double tombstone_ratio) {
+    if (!(tombstone_ratio >= 0.0 && tombstone_ratio <= 1.0)) {
+        throw std::invalid_argument("compaction threshold must be in [0, 1]"s);
+    }
+
+    compaction_threshold_ = tombstone_ratio;
+}
+
 bool SearchServer::IsValidWord(const std::string_view word) const {
     // A valid word must not contain special characters
     return std::none_of(word.begin(), word.end(), [](auto c) { return c >= '\0' && c < ' '; });
@@ -65,35 +97,44 @@ bool SearchServer::AddDocument(int document_id, const std::string_view document,
         throw std::invalid_argument("repeating ids are not allowed"s);
     }
 
-    if (!IsValidWord(document)) {
+    // reused by every document added on this thread
+    thread_local std::vector<std::string_view> words;
+
+    // splitting and validation are a single pass over the document
+    if (!string_processing::SplitIntoWordsValidated(document, words)) {
         throw std::invalid_argument("word in document contains unaccaptable symbol"s);
     }
 
-    const std::vector<std::string_view> words = SplitIntoWordsNoStop(document);
+    RemoveStopWords(words);
 
-    // save words to the server
-    for (const auto word : words) {
-        words_storage_.Insert(word);
+    // postings left by an earlier document with this id would merge with the new ones
+    if (removed_documents_.Contains(document_id)) {
+        Compact();
     }
 
-    const double inverse_word_count = 1.0 / static_cast<double>(words.size());
-
-    std::map<std::string_view, double> word_frequencies;
+    // intern words, from here on the document is a list of term ids
+    thread_local std::vector<TermId> term_ids;
+    term_ids.clear();
 
     for (const std::string_view word : words) {
-        // WordStorage has all the words that have been added to the search_server
-        const auto iterator_to_word_view_in_storage = words_storage_.Find(word);
-        assert(iterator_to_word_view_in_storage != words_storage_.end());
+        term_ids.push_back(words_storage_.Insert(word));
+    }
+
+    posting_lists_.resize(words_storage_.Size());
 
-        // use string views that store data in words_storage_ as keys
-        word_to_document_id_to_term_frequency_[*iterator_to_word_view_in_storage][document_id] += inverse_word_count;
-        word_frequencies[*iterator_to_word_view_in_storage] += inverse_word_count;
+    std::vector<TermFrequency> term_frequencies = ComputeTermFrequencies(term_ids);
+
+    // one posting per distinct word, appended to the end of the list for increasing ids
+    for (const auto& [term_id, term_frequency] : term_frequencies) {
+        posting_lists_[term_id].Add(document_id, term_frequency);
     }
 
     document_ids_.insert(document_id);
 
-    document_id_to_document_data_.emplace(document_id,
-                                          DocumentData{ComputeAverageRating(ratings), status, word_frequencies});
+    document_id_to_document_data_.emplace(
+        document_id, DocumentData{ComputeAverageRating(ratings), status, std::move(term_frequencies)});
+
+    OnDocumentsChanged();
 
     return true;  // this return is kind of redundant
 }  // AddDocument
@@ -103,29 +144,115 @@ int SearchServer::GetDocumentCount() const {
 }  // GetDocumentCount
 
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query,
-                                                     const DocumentStatus& desired_status) const {
-    const auto predicate = [desired_status](int, DocumentStatus document_status, int) {
-        return document_status == desired_status;
-    };
-
-    return FindTopDocuments(std::execution::seq, raw_query, predicate);
+                                                     const DocumentStatus& desired_status,
+                                                     int max_result_document_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, desired_status, max_result_document_count);
 }  // FindTopDocuments with status as a second argument
 
+std::vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query, const DocumentStatus& desired_status,
+                                                     int max_result_document_count) const {
+    return FindTopDocuments(std::execution::seq, query, desired_status, max_result_document_count);
+}
+
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::string_view raw_query,
                                                                                       int document_id) const {
     return MatchDocument(std::execution::seq, raw_query, document_id);
 }
 
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(const std::string_view text) const {
-    std::vector<std::string_view> words;
-    for (const std::string_view word : string_processing::SplitIntoWords(text)) {
-        if (!IsStopWord(word)) {
-            words.push_back(word);
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const PreparedQuery& query,
+                                                                                      int document_id) const {
+    return MatchDocument(std::execution::seq, query, document_id);
+}
+
+MatchedWordsTable SearchServer::MatchDocuments(const PreparedQuery& query, std::vector<int> document_ids) const {
+    return MatchDocuments(std::execution::seq, query, std::move(document_ids));
+}
+
+MatchedWordsTable SearchServer::MatchDocuments(const PreparedQuery& query, int first_document_id,
+                                               int last_document_id) const {
+    return MatchDocuments(std::execution::seq, query, first_document_id, last_document_id);
+}
+
+namespace {
+
+// Calls action(position in documents) for every document id present in both sorted ranges. Whichever range is
+// behind jumps forward by binary search, so a short range costs O(short * log long) against a long one
+template <typename Action>
+void ForEachCommonDocument(const int* first_posting, const int* last_posting, const int* first_document,
+                           const int* last_document, Action action) {
+    const int* const documents_begin = first_document;
+
+    while (first_posting != last_posting && first_document != last_document) {
+        if (*first_posting < *first_document) {
+            first_posting = std::lower_bound(first_posting, last_posting, *first_document);
+        } else if (*first_document < *first_posting) {
+            first_document = std::lower_bound(first_document, last_document, *first_posting);
+        } else {
+            action(static_cast<size_t>(first_document - documents_begin));
+            ++first_posting;
+            ++first_document;
+        }
+    }
+}
+
+}  // namespace
+
+void SearchServer::FillMatchedWordsTable(const PreparedQuery& query, const std::vector<size_t>& bit_of_plus_word,
+                                         const int* first_document_id, const int* last_document_id, size_t first_row,
+                                         MatchedWordsTable& table) const {
+    for (size_t word_index = 0; word_index < query.plus_words_.size(); ++word_index) {
+        const auto& document_ids = posting_lists_[query.plus_words_[word_index].term_id].GetDocumentIds();
+
+        ForEachCommonDocument(document_ids.data(), document_ids.data() + document_ids.size(), first_document_id,
+                              last_document_id, [&](size_t position) {
+                                  table.SetMatched(first_row + position, bit_of_plus_word[word_index]);
+                              });
+    }
+
+    // a minus word wipes the whole row, like MatchDocument returns no words
+    for (const auto& word : query.minus_words_) {
+        const auto& document_ids = posting_lists_[word.term_id].GetDocumentIds();
+
+        ForEachCommonDocument(document_ids.data(), document_ids.data() + document_ids.size(), first_document_id,
+                              last_document_id, [&](size_t position) { table.ClearRow(first_row + position); });
+    }
+}
+
+void SearchServer::RemoveStopWords(std::vector<std::string_view>& words) const {
+    words.erase(std::remove_if(words.begin(), words.end(), [this](std::string_view word) { return IsStopWord(word); }),
+                words.end());
+}  // RemoveStopWords
+
+void SearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    AddDocuments(std::execution::seq, documents);
+}
+
+std::vector<SearchServer::TermFrequency> SearchServer::ComputeTermFrequencies(std::vector<TermId>& term_ids) {
+    std::sort(term_ids.begin(), term_ids.end());
+
+    const double inverse_word_count = 1.0 / static_cast<double>(term_ids.size());
+
+    std::vector<TermFrequency> term_frequencies;
+    term_frequencies.reserve(term_ids.size());
+
+    for (const TermId term_id : term_ids) {
+        if (!term_frequencies.empty() && term_frequencies.back().term_id == term_id) {
+            term_frequencies.back().frequency += inverse_word_count;
+        } else {
+            term_frequencies.push_back({term_id, inverse_word_count});
         }
     }
 
-    return words;
-}  // SplitIntoWordsNoStop
+    return term_frequencies;
+}  // ComputeTermFrequencies
+
+bool SearchServer::IsMoreRelevant(const Document& left, const Document& right) {
+    if (std::abs(left.relevance - right.relevance) < kAccuracy) {
+        return left.rating > right.rating;
+    }
+
+    return left.relevance > right.relevance;
+}  // IsMoreRelevant
 
 int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     int rating_sum = 0;
@@ -139,53 +266,179 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
 
 bool SearchServer::IsStopWord(const std::string_view word) const { return stop_words_.count(word) > 0; }  // IsStopWord
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const {
-    try {
+SearchServer::QueryWord SearchServer::ParseQueryWordSyntax(std::string_view text) {
+    QueryWord query_word;
+
+    if (text.empty()) {
+        query_word.error = "caught empty word, check for double spaces"sv;
+        return query_word;
+    }
+
+    if (text[0] == '-') {
+        text = text.substr(1);
+
         if (text.empty()) {
-            throw std::invalid_argument("caught empty word, check for double spaces"s);
+            query_word.error = "empty minus words are not allowed"sv;
+            return query_word;
+        }
+
+        if (text[0] == '-') {
+            query_word.error = "double minus words are not allowed"sv;
+            return query_word;
         }
-    } catch (...) {
-        exception_pointer_in_parse_query_word = std::current_exception();
+
+        query_word.is_minus = true;
     }
 
-    bool is_minus = false;
+    // control characters are rejected by the tokenizer before words are parsed
 
-    try {
-        if (text[0] == '-') {
-            text = text.substr(1);
+    query_word.data = text;
+
+    return query_word;
+}  // ParseQueryWordSyntax
+
+SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const {
+    QueryWord query_word = ParseQueryWordSyntax(text);
+
+    if (query_word.error.empty()) {
+        query_word.is_stop = IsStopWord(query_word.data);
+    }
+
+    return query_word;
+}  // ParseQueryWord
 
-            if (text.empty()) {
-                throw std::invalid_argument("empty minus words are not allowed"s);
-            }
+SearchServer::PreparedQuery SearchServer::BindQuery(const Query& query) const {
+    PreparedQuery prepared_query;
 
-            if (text[0] == '-') {
-                throw std::invalid_argument("double minus words are not allowed"s);
-            }
+    // words that are not in any document are dropped
+    const auto find_indexed_term = [this](std::string_view word) -> std::optional<TermId> {
+        const auto term_id = words_storage_.Find(word);
 
-            is_minus = true;
+        if (term_id && GetDocumentFrequency(*term_id) != 0) {
+            return term_id;
         }
 
-        if (!IsValidWord(text)) {
-            throw std::invalid_argument("special symbols in words are not allowed"s);
+        return std::nullopt;
+    };
+
+    for (const std::string_view word : query.plus_words) {
+        if (const auto term_id = find_indexed_term(word)) {
+            prepared_query.plus_words_.push_back({*term_id, GetWordInverseDocumentFrequency(*term_id)});
         }
-    } catch (...) {
-        exception_pointer_in_parse_query_word = std::current_exception();
     }
 
-    return {text, is_minus, IsStopWord(text)};
-}  // ParseQueryWord
+    for (const std::string_view word : query.minus_words) {
+        if (const auto term_id = find_indexed_term(word)) {
+            prepared_query.minus_words_.push_back({*term_id, 0.0});
+        }
+    }
+
+    // rare words first: they decide the most and are the cheapest to walk
+    const auto by_posting_list_size = [this](const PreparedQuery::Word& left, const PreparedQuery::Word& right) {
+        return GetDocumentFrequency(left.term_id) < GetDocumentFrequency(right.term_id);
+    };
+
+    std::stable_sort(prepared_query.plus_words_.begin(), prepared_query.plus_words_.end(), by_posting_list_size);
+    std::stable_sort(prepared_query.minus_words_.begin(), prepared_query.minus_words_.end(), by_posting_list_size);
+
+    return prepared_query;
+}  // BindQuery
+
+std::string SearchServer::MakeResultCacheKey(const Query& query, DocumentStatus status,
+                                             int max_result_document_count) const {
+    // words hold no spaces, and parsed minus words have lost their minus, so every key reads back one way
+    std::string key;
+
+    for (const std::string_view word : query.plus_words) {
+        key.append(word).push_back(' ');
+    }
+
+    for (const std::string_view word : query.minus_words) {
+        key.push_back('-');
+        key.append(word).push_back(' ');
+    }
+
+    key += std::to_string(static_cast<int>(status)) + ' ' + std::to_string(max_result_document_count) + ' ' +
+           std::to_string(static_cast<int>(retrieval_mode_));
+
+    return key;
+}
+
+SearchServer::PreparedQuery SearchServer::PrepareQuery(const std::string_view raw_query) const {
+    return PrepareQuery(std::execution::seq, raw_query);
+}
+
+int64_t SearchServer::GetDocumentIdBound() const {
+    return document_ids_.empty() ? 0 : int64_t{*document_ids_.rbegin()} + 1;
+}
+
+void SearchServer::SetParallelScoringShardCount(int shard_count) {
+    if (shard_count <= 0) {
+        throw std::invalid_argument("shard count must be positive"s);
+    }
+
+    parallel_scoring_shard_count_ = shard_count;
+}
+
+void SearchServer::SetRetrievalMode(RetrievalMode retrieval_mode) { retrieval_mode_ = retrieval_mode; }
+
+void SearchServer::SetResultCacheCapacity(size_t capacity) { result_cache_.SetCapacity(capacity); }
+
+SearchServer::ResultCacheStatistics SearchServer::GetResultCacheStatistics() const {
+    return result_cache_.GetStatistics();
+}
 
 // Existence required
-double SearchServer::ComputeWordInverseDocumentFrequency(const std::string_view word) const {
-    assert(word_to_document_id_to_term_frequency_.count(word) != 0);
+double SearchServer::ComputeWordInverseDocumentFrequency(TermId term_id) const {
+    assert(term_id < posting_lists_.size());
 
-    const size_t number_of_documents_constains_word = word_to_document_id_to_term_frequency_.at(word).size();
+    const size_t number_of_documents_constains_word = GetDocumentFrequency(term_id);
 
     assert(number_of_documents_constains_word != 0);
 
     return std::log(static_cast<double>(GetDocumentCount()) / number_of_documents_constains_word);
 }  // ComputeWordInverseDocumentFrequency
 
+double SearchServer::GetWordInverseDocumentFrequency(TermId term_id) const {
+    return inverse_document_frequencies_.Get(term_id,
+                                             [this, term_id]() { return ComputeWordInverseDocumentFrequency(term_id); });
+}
+
+void SearchServer::OnDocumentsChanged() {
+    // new terms start stale, and the document count has changed for every other term
+    inverse_document_frequencies_.Resize(posting_lists_.size());
+    inverse_document_frequencies_.Invalidate();
+
+    removed_posting_counts_.resize(posting_lists_.size(), 0);
+
+    result_cache_.Invalidate();
+}
+
+size_t SearchServer::GetDocumentFrequency(TermId term_id) const {
+    const size_t removed_posting_count = term_id < removed_posting_counts_.size() ? removed_posting_counts_[term_id] : 0;
+    return posting_lists_[term_id].Size() - removed_posting_count;
+}
+
+search_server_storage_container::PostingList SearchServer::GetLivePostings(TermId term_id) const {
+    const auto& posting_list = posting_lists_[term_id];
+    const auto& document_ids = posting_list.GetDocumentIds();
+    const auto& term_frequencies = posting_list.GetTermFrequencies();
+
+    std::vector<int> live_document_ids;
+    std::vector<double> live_term_frequencies;
+    live_document_ids.reserve(GetDocumentFrequency(term_id));
+    live_term_frequencies.reserve(GetDocumentFrequency(term_id));
+
+    for (size_t index = 0; index < document_ids.size(); ++index) {
+        if (!removed_documents_.Contains(document_ids[index])) {
+            live_document_ids.push_back(document_ids[index]);
+            live_term_frequencies.push_back(term_frequencies[index]);
+        }
+    }
+
+    return search_server_storage_container::PostingList(std::move(live_document_ids), std::move(live_term_frequencies));
+}
+
 namespace search_server_helpers {
 
 void PrintMatchDocumentResult(int document_id, const std::vector<std::string_view> words, DocumentStatus status) {
@@ -231,10 +484,12 @@ void MatchDocuments(const SearchServer& search_server, const std::string_view qu
     try {
         std::cout << "Матчинг документов по запросу: "s << query << std::endl;
 
-        for (const int document_id : search_server) {
-            const auto [words, status] = search_server.MatchDocument(query, document_id);
+        // the query is parsed once and every posting list is walked once for all documents
+        const auto table = search_server.MatchDocuments(search_server.PrepareQuery(query),
+                                                        std::vector<int>(search_server.begin(), search_server.end()));
 
-            PrintMatchDocumentResult(document_id, words, status);
+        for (size_t row = 0; row < table.GetDocumentCount(); ++row) {
+            PrintMatchDocumentResult(table.GetDocumentId(row), table.GetMatchedWords(row), table.GetStatus(row));
         }
 
     } catch (const std::exception& e) {
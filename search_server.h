@@ -1,34 +1,85 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <execution>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <map>
 #include <mutex>
+#include <numeric>
+#include <optional>
 #include <set>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
-#include "concurrent_map.h"
 #include "document.h"
+#include "document_bitmap.h"
+#include "inverse_document_frequency_cache.h"
+#include "matched_words_table.h"
+#include "max_score_retrieval.h"
+#include "posting_list.h"
+#include "query_result_cache.h"
+#include "score_accumulator.h"
 #include "string_processing.h"
+#include "top_k_selector.h"
 #include "word_storage.h"
 
-namespace parallel_copy {
+using namespace std::literals;
 
-template <typename Container, typename Predicate>
-std::vector<typename Container::value_type> CopyIfUnordered(const Container& container, Predicate predicate);
+class SearchServer {
+    // serves snapshots written by SaveSnapshot and answers queries the same way
+    friend class MappedSearchServer;
+    // uses servers as segments, scores them with IDF over all segments and merges them
+    friend class SegmentedSearchServer;
+    // compresses the postings of a server and answers queries the same way
+    friend class CompressedSearchServer;
 
-}  // namespace parallel_copy
+   public:
+    static constexpr int kDefaultMaxResultDocumentCount = 5;
 
-using namespace std::literals;
+    // Share of removed documents whose postings may stay in the index before RemoveDocument purges them
+    static constexpr double kDefaultCompactionThreshold = 0.2;
 
-static std::exception_ptr exception_pointer_in_parse_query_word = nullptr;
+    // How FindTopDocuments walks the posting lists. EXHAUSTIVE scores every posting of every plus word,
+    // MAX_SCORE skips documents whose score bound can not get them into the top results. Both return the same
+    // results, except that documents tied in relevance and rating may be picked differently
+    enum class RetrievalMode { EXHAUSTIVE, MAX_SCORE };
+
+    using TermId = search_server_storage_container::TermId;
+
+    struct TermFrequency {
+        TermId term_id = 0;
+        double frequency = 0.0;
+    };
+
+    // A query parsed once and bound to the index: its words are resolved to term ids, carry precomputed IDF and
+    // are ordered by posting list length. It can be executed any number of times, but only until the server it was
+    // prepared by is modified
+    class PreparedQuery {
+       public:
+        bool HasPlusWords() const { return !plus_words_.empty(); }
+
+       private:
+        friend class SearchServer;
+        friend class SegmentedSearchServer;
+
+        struct Word {
+            TermId term_id = 0;
+            double inverse_document_frequency = 0.0;
+        };
+
+       private:
+        // words that are not indexed can neither match nor exclude anything and are dropped
+        std::vector<Word> plus_words_;
+        std::vector<Word> minus_words_;
+    };
 
-class SearchServer {
    public:
     SearchServer() = default;
 
@@ -45,53 +96,165 @@ class SearchServer {
     bool AddDocument(int document_id, const std::string_view document, DocumentStatus status,
                      const std::vector<int>& ratings);
 
+    struct NewDocument {
+        int id = 0;
+        std::string_view text;
+        DocumentStatus status = DocumentStatus::ACTUAL;
+        std::vector<int> ratings;
+    };
+
+    // Adds a batch of documents: they are tokenized and counted in parallel, and every posting list gets the new
+    // postings in one sorted merge. Throws std::invalid_argument and adds nothing if any document is rejected
+    void AddDocuments(const std::vector<NewDocument>& documents);
+
+    template <typename ExecutionPolicy>
+    void AddDocuments(const ExecutionPolicy& policy, const std::vector<NewDocument>& documents);
+
     int GetDocumentCount() const;
 
+    // Throws std::invalid_argument if the query is malformed
+    PreparedQuery PrepareQuery(const std::string_view raw_query) const;
+
+    template <typename ExecutionPolicy>
+    PreparedQuery PrepareQuery(const ExecutionPolicy& policy, const std::string_view raw_query) const;
+
+    // max_result_document_count limits how many of the most relevant documents are returned
     template <typename Predicate>
-    std::vector<Document> FindTopDocuments(const std::string_view raw_query, Predicate predicate) const;
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, Predicate predicate,
+                                           int max_result_document_count = kDefaultMaxResultDocumentCount) const;
 
     std::vector<Document> FindTopDocuments(const std::string_view raw_query,
-                                           const DocumentStatus& desired_status = DocumentStatus::ACTUAL) const;
+                                           const DocumentStatus& desired_status = DocumentStatus::ACTUAL,
+                                           int max_result_document_count = kDefaultMaxResultDocumentCount) const;
 
     template <typename Execution, typename Predicate>
-    std::vector<Document> FindTopDocuments(Execution policy, const std::string_view raw_query,
-                                           Predicate predicate) const;
+    std::vector<Document> FindTopDocuments(Execution policy, const std::string_view raw_query, Predicate predicate,
+                                           int max_result_document_count = kDefaultMaxResultDocumentCount) const;
 
     template <typename Execution>
     std::vector<Document> FindTopDocuments(Execution policy, const std::string_view raw_query,
-                                           const DocumentStatus& desired_status) const;
+                                           const DocumentStatus& desired_status,
+                                           int max_result_document_count = kDefaultMaxResultDocumentCount) const;
+
+    template <typename Predicate>
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query, Predicate predicate,
+                                           int max_result_document_count = kDefaultMaxResultDocumentCount) const;
+
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query,
+                                           const DocumentStatus& desired_status = DocumentStatus::ACTUAL,
+                                           int max_result_document_count = kDefaultMaxResultDocumentCount) const;
+
+    template <typename Execution, typename Predicate>
+    std::vector<Document> FindTopDocuments(Execution policy, const PreparedQuery& query, Predicate predicate,
+                                           int max_result_document_count = kDefaultMaxResultDocumentCount) const;
+
+    template <typename Execution>
+    std::vector<Document> FindTopDocuments(Execution policy, const PreparedQuery& query,
+                                           const DocumentStatus& desired_status,
+                                           int max_result_document_count = kDefaultMaxResultDocumentCount) const;
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query,
                                                                             const int document_id) const;
 
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const PreparedQuery& query,
+                                                                            const int document_id) const;
+
     template <typename ExecutionPolicy>
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const ExecutionPolicy& policy,
                                                                             const std::string_view raw_query,
                                                                             const int document_id) const;
 
+    template <typename ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const ExecutionPolicy& policy,
+                                                                            const PreparedQuery& query,
+                                                                            const int document_id) const;
+
+    // Matches the query against a batch of documents walking every posting list once. Rows follow document ids in
+    // increasing order, throws std::out_of_range if a document is not in the server
+    MatchedWordsTable MatchDocuments(const PreparedQuery& query, std::vector<int> document_ids) const;
+
+    template <typename ExecutionPolicy>
+    MatchedWordsTable MatchDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+                                     std::vector<int> document_ids) const;
+
+    // Matches the query against every document with id in [first_document_id, last_document_id)
+    MatchedWordsTable MatchDocuments(const PreparedQuery& query, int first_document_id, int last_document_id) const;
+
+    template <typename ExecutionPolicy>
+    MatchedWordsTable MatchDocuments(const ExecutionPolicy& policy, const PreparedQuery& query, int first_document_id,
+                                     int last_document_id) const;
+
     std::set<int>::const_iterator begin() const;
 
     std::set<int>::const_iterator end() const;
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    std::map<std::string_view, double> GetWordFrequencies(int document_id) const;
+
+    // Same frequencies keyed by term id, sorted by term id
+    const std::vector<TermFrequency>& GetTermFrequencies(int document_id) const;
+
+    // Word of a term id met in GetTermFrequencies
+    std::string_view GetWord(TermId term_id) const;
+
+    // IDF queries score the word with, nullopt for a word in no document
+    std::optional<double> GetInverseDocumentFrequency(std::string_view word) const;
 
+    // Removal is logical: the document is marked in a bitmap queries skip, and its postings are purged by a
+    // compaction once removed documents make up more than the compaction threshold of the documents in the postings
     void RemoveDocument(const int document_id);
 
     template <typename ExecutionPolicy>
     void RemoveDocument(const ExecutionPolicy& p, const int document_id);
 
+    // Purges the postings of every removed document now, lists are compacted concurrently under a parallel policy
+    void Compact();
+
+    template <typename ExecutionPolicy>
+    void Compact(const ExecutionPolicy& policy);
+
+    // 0 purges on every removal, 1 leaves purging to Compact. Throws std::invalid_argument outside [0, 1]
+    void SetCompactionThreshold(double tombstone_ratio);
+
+    // Upper bound on the number of document id ranges a parallel FindTopDocuments scores concurrently,
+    // defaults to the number of hardware threads
+    void SetParallelScoringShardCount(int shard_count);
+
+    void SetRetrievalMode(RetrievalMode retrieval_mode);
+
+    // Results of FindTopDocuments by status are kept for up to capacity distinct queries, least recently used
+    // dropped first, and all are stale once documents are added or removed. Queries are keyed by their words after
+    // parsing, so word order, repeats and stop words do not matter. 0, the default, turns caching off
+    void SetResultCacheCapacity(size_t capacity);
+
+    using ResultCacheStatistics = query_result_caching::QueryResultCache::Statistics;
+
+    ResultCacheStatistics GetResultCacheStatistics() const;
+
+    // Writes stop words, dictionary, postings and documents as a versioned binary snapshot. Every section is a few
+    // flat arrays guarded by a checksum, so loading is a handful of large reads and copies
+    void SaveSnapshot(std::ostream& output) const;
+
+    // Throws std::invalid_argument if the snapshot is truncated, corrupted or of another version
+    static SearchServer LoadSnapshot(std::istream& input);
+
    private:
     struct DocumentData {
         int rating = 0;
         DocumentStatus status = DocumentStatus::ACTUAL;
-        std::map<std::string_view, double> word_frequencies;
+        std::vector<TermFrequency> term_frequencies;
     };
 
     struct Query {
         std::set<std::string_view> plus_words;
         std::set<std::string_view> minus_words;
+        // first error met while parsing, empty for a valid query
+        std::string_view error;
 
         Query& operator+=(Query other) {
+            if (error.empty()) {
+                error = other.error;
+            }
+
             for (const auto& other_plus_word : other.plus_words) {
                 plus_words.insert(other_plus_word);
             }
@@ -104,58 +267,228 @@ class SearchServer {
         }
     };
 
+    // Parsing a word never throws: the error travels with the word, so words can be parsed inside parallel
+    // algorithms without any state shared between queries
     struct QueryWord {
         std::string_view data;
         bool is_minus = false;
         bool is_stop = false;
+        std::string_view error;
+    };
+
+    // Postings of a word in a document id range consumed from the front, a cursor of max_score_retrieval
+    class PostingCursor {
+       public:
+        PostingCursor(const search_server_storage_container::PostingList& posting_list,
+                      double inverse_document_frequency, size_t word_index, int64_t first_document_id,
+                      int64_t last_document_id)
+            : inverse_document_frequency_(inverse_document_frequency),
+              max_score_(posting_list.GetMaxTermFrequency() * inverse_document_frequency),
+              word_index_(word_index),
+              first_posting_(posting_list.GetDocumentIds().data()),
+              block_last_document_ids_(posting_list.GetBlockLastDocumentIds().data()),
+              block_max_term_frequencies_(posting_list.GetBlockMaxTermFrequencies().data()),
+              block_count_(posting_list.GetBlockLastDocumentIds().size()) {
+            const int* const last_posting = first_posting_ + posting_list.Size();
+
+            position_ = std::lower_bound(first_posting_, last_posting, first_document_id);
+            end_ = std::lower_bound(position_, last_posting, last_document_id);
+            term_frequency_ = posting_list.GetTermFrequencies().data() + (position_ - first_posting_);
+            block_ = static_cast<size_t>(position_ - first_posting_) / kBlockSize;
+        }
+
+        int64_t GetDocumentId() const { return position_ == end_ ? max_score_retrieval::kEndDocumentId : *position_; }
+
+        size_t GetWordIndex() const { return word_index_; }
+
+        double GetMaxScore() const { return max_score_; }
+
+        double GetScore() { return *term_frequency_ * inverse_document_frequency_; }
+
+        // Moves to the block that holds document_id if any posting of the list does, blocks span the whole list
+        bool SeekBlock(int64_t document_id) {
+            while (block_ < block_count_ && block_last_document_ids_[block_] < document_id) {
+                ++block_;
+            }
+
+            if (block_ == block_count_) {
+                MoveToPosition(end_);
+                return false;
+            }
+
+            return true;
+        }
+
+        double GetBlockScore() const { return block_max_term_frequencies_[block_] * inverse_document_frequency_; }
+
+        int GetBlockLastDocumentId() const { return block_last_document_ids_[block_]; }
+
+        void MoveTo(int64_t document_id) {
+            if (GetDocumentId() >= document_id || !SeekBlock(document_id)) {
+                return;
+            }
+
+            // only the block can hold the posting, unless the range ends before it
+            const int* const block_begin = first_posting_ + block_ * kBlockSize;
+            const int* const first = std::max(position_, std::min(block_begin, end_));
+            const int* const last = std::min(block_begin + kBlockSize, end_);
+            MoveToPosition(std::lower_bound(first, std::max(first, last), document_id));
+        }
+
+        void Next() { MoveToPosition(position_ + 1); }
+
+       private:
+        static constexpr size_t kBlockSize = search_server_storage_container::PostingList::kBlockSize;
+
+        void MoveToPosition(const int* position) {
+            term_frequency_ += position - position_;
+            position_ = position;
+        }
+
+       private:
+        double inverse_document_frequency_ = 0.0;
+        double max_score_ = 0.0;
+        size_t word_index_ = 0;
+
+        const int* position_ = nullptr;
+        const int* end_ = nullptr;
+        const double* term_frequency_ = nullptr;
+
+        // blocks of the whole list, block_ is the first one that may still hold the postings looked for
+        const int* first_posting_ = nullptr;
+        const int* block_last_document_ids_ = nullptr;
+        const double* block_max_term_frequencies_ = nullptr;
+        size_t block_count_ = 0;
+        size_t block_ = 0;
     };
 
    private:
-    static constexpr int kMaxResultDocumentCount = 5;
     static constexpr double kAccuracy = 1e-6;
 
+    // Shards narrower than this cost more to schedule than to score
+    static constexpr int kMinDocumentIdsPerShard = 4096;
+
    private:
-    std::vector<std::string_view> SplitIntoWordsNoStop(const std::string_view text) const;
+    static bool IsMoreRelevant(const Document& left, const Document& right);
+
+    void RemoveStopWords(std::vector<std::string_view>& words) const;
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
+    // Sorts term_ids of the words of a document and folds repeats into frequencies
+    static std::vector<TermFrequency> ComputeTermFrequencies(std::vector<TermId>& term_ids);
+
     bool IsStopWord(const std::string_view word) const;
 
+    // Checks the syntax of a query word, leaves is_stop unset
+    static QueryWord ParseQueryWordSyntax(std::string_view text);
+
     QueryWord ParseQueryWord(std::string_view text) const;
 
+    // Throws std::invalid_argument if any word of the query is malformed
     template <typename ExecutionPolicy>
     Query ParseQuery(const ExecutionPolicy& p, const std::string_view text) const;
 
     // Existence required
-    double ComputeWordInverseDocumentFrequency(const std::string_view word) const;
+    double ComputeWordInverseDocumentFrequency(TermId term_id) const;
 
-    template <typename Execution>
-    std::vector<Document> FindAllDocuments(Execution policy, const Query& query) const;
+    // Cached ComputeWordInverseDocumentFrequency, existence required
+    double GetWordInverseDocumentFrequency(TermId term_id) const;
+
+    // Every writer calls it once the documents and posting lists are updated
+    void OnDocumentsChanged();
+
+    // Documents holding the term that are not removed
+    size_t GetDocumentFrequency(TermId term_id) const;
+
+    // Copy of the term's postings without those of removed documents
+    search_server_storage_container::PostingList GetLivePostings(TermId term_id) const;
+
+    PreparedQuery BindQuery(const Query& query) const;
+
+    // Sorted plus and minus words, status, result count and retrieval mode
+    std::string MakeResultCacheKey(const Query& query, DocumentStatus status, int max_result_document_count) const;
+
+    // One past the largest document id, 0 for an empty server. Wider than int, the largest id may be INT_MAX
+    int64_t GetDocumentIdBound() const;
+
+    // Scores documents with ids in [first_document_id, last_document_id) and pushes those passing the predicate
+    // to selector. Uses only thread-local state, so disjoint ranges can be scored concurrently without locking
+    template <typename Predicate, typename Selector>
+    void FindAllDocuments(const PreparedQuery& query, int64_t first_document_id, int64_t last_document_id,
+                          Predicate& predicate, Selector& selector) const;
+
+    // Same contract as FindAllDocuments. Walks the plus words document at a time, see max_score_retrieval
+    template <typename Predicate, typename Selector>
+    void FindTopDocumentsWithMaxScore(const PreparedQuery& query, int64_t first_document_id,
+                                      int64_t last_document_id, Predicate& predicate, Selector& selector) const;
 
     bool IsValidWord(const std::string_view word) const;
 
+    // Fills the table rows starting at first_row, which belong to the sorted ids [first_document_id, last_document_id)
+    void FillMatchedWordsTable(const PreparedQuery& query, const std::vector<size_t>& bit_of_plus_word,
+                               const int* first_document_id, const int* last_document_id, size_t first_row,
+                               MatchedWordsTable& table) const;
+
+    template <typename ExecutionPolicy>
+    MatchedWordsTable MatchSortedDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+                                           std::vector<int> document_ids,
+                                           std::vector<DocumentStatus> statuses) const;
+
    private:
     std::set<std::string, std::less<>> stop_words_;
 
     search_server_storage_container::WordStorage words_storage_;
 
-    std::map<std::string_view, std::map<int, double>> word_to_document_id_to_term_frequency_;
+    // indexed by term id, lists of words that are no longer in any document stay empty
+    std::vector<search_server_storage_container::PostingList> posting_lists_;
+
+    // indexed by term id as posting lists, may be shorter for servers built from parts
+    search_server_storage_container::InverseDocumentFrequencyCache inverse_document_frequencies_;
 
     std::map<int, DocumentData> document_id_to_document_data_;
 
     std::set<int> document_ids_;
+
+    // documents removed but still in the posting lists, and how many of them each term has
+    search_server_storage_container::DocumentBitmap removed_documents_;
+    std::vector<uint32_t> removed_posting_counts_;
+    size_t removed_document_count_ = 0;
+    double compaction_threshold_ = kDefaultCompactionThreshold;
+
+    int parallel_scoring_shard_count_ = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    RetrievalMode retrieval_mode_ = RetrievalMode::MAX_SCORE;
+
+    query_result_caching::QueryResultCache result_cache_;
 };
 
 template <typename ExecutionPolicy>
 SearchServer::Query SearchServer::ParseQuery(const ExecutionPolicy& policy, const std::string_view text) const {
-    auto words = string_processing::SplitIntoWords(text);
+    // a sequential parse reuses a buffer of this thread. A parallel reduce may run other tasks on this thread while
+    // it waits, and one of them could parse another query into that buffer mid-iteration, so it gets its own
+    std::vector<std::string_view> local_words;
+    std::vector<std::string_view>& words = [&local_words]() -> std::vector<std::string_view>& {
+        if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
+            thread_local std::vector<std::string_view> sequential_words;
+            return sequential_words;
+        } else {
+            return local_words;
+        }
+    }();
+
+    if (!string_processing::SplitIntoWordsValidated(text, words)) {
+        throw std::invalid_argument("special symbols in words are not allowed"s);
+    }
 
     // UnaryOp
     const auto transform_word_in_query = [this](const std::string_view word) {
         auto query_word = this->ParseQueryWord(word);
 
         Query query;
-        if (!query_word.is_stop) {
+        if (!query_word.error.empty()) {
+            query.error = query_word.error;
+        } else if (!query_word.is_stop) {
             if (query_word.is_minus) {
                 query.minus_words.insert(query_word.data);
             } else {
@@ -169,71 +502,325 @@ SearchServer::Query SearchServer::ParseQuery(const ExecutionPolicy& policy, cons
     // BinaryOp
     const auto combine_queries = [](Query first, Query second) { return first += second; };
 
-    return std::transform_reduce(policy, std::make_move_iterator(words.begin()), std::make_move_iterator(words.end()),
-                                 Query{}, combine_queries, transform_word_in_query);
+    Query query = std::transform_reduce(policy, std::make_move_iterator(words.begin()),
+                                        std::make_move_iterator(words.end()), Query{}, combine_queries,
+                                        transform_word_in_query);
+
+    if (!query.error.empty()) {
+        throw std::invalid_argument(std::string(query.error));
+    }
+
+    return query;
 }  // ParseQuery
 
+template <typename ExecutionPolicy>
+SearchServer::PreparedQuery SearchServer::PrepareQuery(const ExecutionPolicy& policy,
+                                                       const std::string_view raw_query) const {
+    return BindQuery(ParseQuery(policy, raw_query));
+}  // PrepareQuery
+
 template <typename ExecutionPolicy>
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const ExecutionPolicy& policy,
                                                                                       const std::string_view raw_query,
                                                                                       int document_id) const {
-    const Query query = ParseQuery(policy, raw_query);
+    return MatchDocument(policy, PrepareQuery(policy, raw_query), document_id);
+}
+
+template <typename ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const ExecutionPolicy& policy,
+                                                                                      const PreparedQuery& query,
+                                                                                      int document_id) const {
+    const DocumentStatus status = document_id_to_document_data_.at(document_id).status;
 
-    const auto word_checker = [this, document_id](std::string_view word) {
-        const auto it = word_to_document_id_to_term_frequency_.find(word);
-        return it != word_to_document_id_to_term_frequency_.end() && it->second.count(document_id);
+    const auto word_checker = [this, document_id](const PreparedQuery::Word& word) {
+        return posting_lists_[word.term_id].Contains(document_id);
     };
 
     std::vector<std::string_view> matched_words;
-    std::copy_if(std::execution::par, query.plus_words.begin(), query.plus_words.end(), std::back_inserter(matched_words), word_checker);
 
-    bool is_minus_word_in_document = std::any_of(std::execution::par, query.minus_words.begin(), query.minus_words.end(), word_checker);
+    if (std::any_of(policy, query.minus_words_.begin(), query.minus_words_.end(), word_checker)) {
+        return {matched_words, status};
+    }
 
-    if (is_minus_word_in_document) {
-        matched_words.clear();
+    for (const auto& word : query.plus_words_) {
+        if (word_checker(word)) {
+            matched_words.push_back(words_storage_.GetWord(word.term_id));
+        }
     }
 
-    return std::tuple<std::vector<std::string_view>, DocumentStatus>{
-        matched_words, document_id_to_document_data_.at(document_id).status};
+    // plus words are ordered for scoring, matched words are reported alphabetically
+    std::sort(matched_words.begin(), matched_words.end());
+
+    return {matched_words, status};
 }  // MatchDocument
 
 template <typename ExecutionPolicy>
-void SearchServer::RemoveDocument(const ExecutionPolicy& policy, const int document_id) {
-    if (document_id_to_document_data_.count(document_id) == 0) {
-        return;
+MatchedWordsTable SearchServer::MatchDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+                                               std::vector<int> document_ids) const {
+    std::sort(document_ids.begin(), document_ids.end());
+    document_ids.erase(std::unique(document_ids.begin(), document_ids.end()), document_ids.end());
+
+    std::vector<DocumentStatus> statuses;
+    statuses.reserve(document_ids.size());
+
+    for (const int document_id : document_ids) {
+        statuses.push_back(document_id_to_document_data_.at(document_id).status);
+    }
+
+    return MatchSortedDocuments(policy, query, std::move(document_ids), std::move(statuses));
+}
+
+template <typename ExecutionPolicy>
+MatchedWordsTable SearchServer::MatchDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+                                               int first_document_id, int last_document_id) const {
+    std::vector<int> document_ids;
+    std::vector<DocumentStatus> statuses;
+
+    for (auto it = document_id_to_document_data_.lower_bound(first_document_id);
+         it != document_id_to_document_data_.end() && it->first < last_document_id; ++it) {
+        document_ids.push_back(it->first);
+        statuses.push_back(it->second.status);
     }
 
-    // get list of words that are in this doc
-    const auto words_and_frequencies = GetWordFrequencies(document_id);
+    return MatchSortedDocuments(policy, query, std::move(document_ids), std::move(statuses));
+}
 
-    // initialize linear container that will contain inner maps of word_to_document_id_to_term_frequency where id points
-    // to frequency
-    std::vector<std::map<int, double>> id_to_frequency;
-    id_to_frequency.reserve(words_and_frequencies.size());
+template <typename ExecutionPolicy>
+MatchedWordsTable SearchServer::MatchSortedDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+                                                     std::vector<int> document_ids,
+                                                     std::vector<DocumentStatus> statuses) const {
+    // bits follow the alphabetical order of words, like the words MatchDocument returns
+    std::vector<std::string_view> words;
+    for (const auto& word : query.plus_words_) {
+        words.push_back(words_storage_.GetWord(word.term_id));
+    }
+    std::sort(words.begin(), words.end());
 
-    // populate this inner container
-    for (const auto& [word, term_frequency] : words_and_frequencies) {
-        id_to_frequency.push_back(std::move(word_to_document_id_to_term_frequency_.at(word)));
+    std::vector<size_t> bit_of_plus_word;
+    for (const auto& word : query.plus_words_) {
+        bit_of_plus_word.push_back(
+            std::lower_bound(words.begin(), words.end(), words_storage_.GetWord(word.term_id)) - words.begin());
     }
 
-    // change inner maps
-    std::for_each(policy, id_to_frequency.begin(), id_to_frequency.end(),
-                  [document_id](std::map<int, double>& element) { element.erase(document_id); });
+    MatchedWordsTable table(std::move(words), std::move(document_ids), std::move(statuses));
 
-    // and put them back
-    auto iterator_for_id_to_frequency_maps = id_to_frequency.begin();
-    for (const auto& [word, term_frequency] : words_and_frequencies) {
-        word_to_document_id_to_term_frequency_.at(word) = std::move(*(iterator_for_id_to_frequency_maps++));
+    const size_t document_count = table.GetDocumentCount();
+    const int* document_ids_data = table.GetDocumentIds().data();
 
-        if (word_to_document_id_to_term_frequency_.at(word).empty()) {
-            word_to_document_id_to_term_frequency_.erase(word);
+    if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
+        FillMatchedWordsTable(query, bit_of_plus_word, document_ids_data, document_ids_data + document_count, 0,
+                              table);
+    } else {
+        // chunks own disjoint rows, so the table is filled without locking
+        const size_t chunk_count =
+            std::min(static_cast<size_t>(parallel_scoring_shard_count_), std::max<size_t>(1, document_count));
+        const size_t chunk_size = (document_count + chunk_count - 1) / chunk_count;
+
+        std::vector<size_t> chunk_indices(chunk_count);
+        std::iota(chunk_indices.begin(), chunk_indices.end(), 0);
+
+        std::for_each(policy, chunk_indices.begin(), chunk_indices.end(), [&](size_t chunk_index) {
+            const size_t first_row = std::min(chunk_index * chunk_size, document_count);
+            const size_t last_row = std::min(first_row + chunk_size, document_count);
+            FillMatchedWordsTable(query, bit_of_plus_word, document_ids_data + first_row,
+                                  document_ids_data + last_row, first_row, table);
+        });
+    }
+
+    return table;
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::AddDocuments(const ExecutionPolicy& policy, const std::vector<NewDocument>& documents) {
+    std::vector<int> new_document_ids;
+    new_document_ids.reserve(documents.size());
+
+    for (const NewDocument& document : documents) {
+        if (document.id < 0) {
+            throw std::invalid_argument("negative ids are not allowed"s);
+        }
+
+        if (document_id_to_document_data_.count(document.id) > 0) {
+            throw std::invalid_argument("repeating ids are not allowed"s);
+        }
+
+        new_document_ids.push_back(document.id);
+    }
+
+    std::sort(new_document_ids.begin(), new_document_ids.end());
+
+    if (std::adjacent_find(new_document_ids.begin(), new_document_ids.end()) != new_document_ids.end()) {
+        throw std::invalid_argument("repeating ids are not allowed"s);
+    }
+
+    // postings left by earlier documents with these ids would merge with the new ones
+    if (std::any_of(new_document_ids.begin(), new_document_ids.end(),
+                    [this](int document_id) { return removed_documents_.Contains(document_id); })) {
+        Compact(policy);
+    }
+
+    struct TokenizedDocument {
+        std::vector<std::string_view> words;
+        std::vector<TermId> term_ids;
+        bool is_valid = false;
+    };
+
+    constexpr TermId kUnknownTermId = std::numeric_limits<TermId>::max();
+
+    std::vector<TokenizedDocument> tokenized_documents(documents.size());
+    std::vector<size_t> document_indices(documents.size());
+    std::iota(document_indices.begin(), document_indices.end(), 0);
+
+    // every document is tokenized into its own buffers, words known to the storage are resolved read-only
+    std::for_each(policy, document_indices.begin(), document_indices.end(), [&](size_t index) {
+        TokenizedDocument& tokenized_document = tokenized_documents[index];
+
+        tokenized_document.is_valid =
+            string_processing::SplitIntoWordsValidated(documents[index].text, tokenized_document.words);
+
+        if (!tokenized_document.is_valid) {
+            return;
+        }
+
+        RemoveStopWords(tokenized_document.words);
+
+        tokenized_document.term_ids.reserve(tokenized_document.words.size());
+
+        for (const std::string_view word : tokenized_document.words) {
+            tokenized_document.term_ids.push_back(words_storage_.Find(word).value_or(kUnknownTermId));
+        }
+    });
+
+    for (const TokenizedDocument& tokenized_document : tokenized_documents) {
+        if (!tokenized_document.is_valid) {
+            throw std::invalid_argument("word in document contains unaccaptable symbol"s);
+        }
+    }
+
+    // only words met for the first time go through the storage one by one
+    for (TokenizedDocument& tokenized_document : tokenized_documents) {
+        for (size_t i = 0; i < tokenized_document.words.size(); ++i) {
+            if (tokenized_document.term_ids[i] == kUnknownTermId) {
+                tokenized_document.term_ids[i] = words_storage_.Insert(tokenized_document.words[i]);
+            }
         }
     }
 
-    // not parallel
-    document_id_to_document_data_.erase(document_id);
+    posting_lists_.resize(words_storage_.Size());
+
+    std::vector<std::vector<TermFrequency>> term_frequencies(documents.size());
+
+    std::for_each(policy, document_indices.begin(), document_indices.end(), [&](size_t index) {
+        term_frequencies[index] = ComputeTermFrequencies(tokenized_documents[index].term_ids);
+        tokenized_documents[index] = {};
+    });
+
+    // postings are bucketed by term in increasing document id order, so every bucket comes out sorted
+    std::sort(document_indices.begin(), document_indices.end(),
+              [&documents](size_t left, size_t right) { return documents[left].id < documents[right].id; });
+
+    std::vector<size_t> term_offsets(posting_lists_.size() + 1, 0);
+
+    for (const auto& document_term_frequencies : term_frequencies) {
+        for (const TermFrequency& term_frequency : document_term_frequencies) {
+            ++term_offsets[term_frequency.term_id + 1];
+        }
+    }
+
+    std::partial_sum(term_offsets.begin(), term_offsets.end(), term_offsets.begin());
+
+    std::vector<int> new_posting_document_ids(term_offsets.back());
+    std::vector<double> new_posting_term_frequencies(term_offsets.back());
+    std::vector<size_t> term_cursors(term_offsets.begin(), term_offsets.end() - 1);
+
+    for (const size_t index : document_indices) {
+        for (const auto& [term_id, frequency] : term_frequencies[index]) {
+            const size_t position = term_cursors[term_id]++;
+            new_posting_document_ids[position] = documents[index].id;
+            new_posting_term_frequencies[position] = frequency;
+        }
+    }
+
+    std::vector<TermId> touched_term_ids;
+
+    for (TermId term_id = 0; term_id < posting_lists_.size(); ++term_id) {
+        if (term_offsets[term_id + 1] > term_offsets[term_id]) {
+            touched_term_ids.push_back(term_id);
+        }
+    }
+
+    // every posting list is merged by exactly one task
+    std::for_each(policy, touched_term_ids.begin(), touched_term_ids.end(), [&](TermId term_id) {
+        const size_t offset = term_offsets[term_id];
+        posting_lists_[term_id].Merge(new_posting_document_ids.data() + offset,
+                                      new_posting_term_frequencies.data() + offset,
+                                      term_offsets[term_id + 1] - offset);
+    });
+
+    for (const size_t index : document_indices) {
+        const NewDocument& document = documents[index];
+
+        document_ids_.insert(document_ids_.end(), document.id);
+        document_id_to_document_data_.emplace_hint(
+            document_id_to_document_data_.end(), document.id,
+            DocumentData{ComputeAverageRating(document.ratings), document.status, std::move(term_frequencies[index])});
+    }
+
+    OnDocumentsChanged();
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::RemoveDocument(const ExecutionPolicy& policy, const int document_id) {
+    const auto document_data = document_id_to_document_data_.find(document_id);
+
+    if (document_data == document_id_to_document_data_.end()) {
+        return;
+    }
+
+    // the postings stay where they are, queries skip them by the bitmap
+    removed_documents_.Insert(document_id);
+    ++removed_document_count_;
+
+    for (const auto& term_frequency : document_data->second.term_frequencies) {
+        ++removed_posting_counts_[term_frequency.term_id];
+    }
+
+    document_id_to_document_data_.erase(document_data);
 
     document_ids_.erase(document_id);
+
+    OnDocumentsChanged();
+
+    const double tombstone_ratio = static_cast<double>(removed_document_count_) /
+                                   static_cast<double>(removed_document_count_ + document_ids_.size());
+
+    if (tombstone_ratio > compaction_threshold_) {
+        Compact(policy);
+    }
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::Compact(const ExecutionPolicy& policy) {
+    if (removed_document_count_ == 0) {
+        return;
+    }
+
+    std::vector<TermId> term_ids;
+    for (TermId term_id = 0; term_id < removed_posting_counts_.size(); ++term_id) {
+        if (removed_posting_counts_[term_id] > 0) {
+            term_ids.push_back(term_id);
+        }
+    }
+
+    // every posting list is rebuilt by exactly one task
+    std::for_each(policy, term_ids.begin(), term_ids.end(), [this](TermId term_id) {
+        posting_lists_[term_id] = GetLivePostings(term_id);
+        removed_posting_counts_[term_id] = 0;
+    });
+
+    // document frequencies do not change, so cached IDF stays valid
+    removed_documents_.Clear();
+    removed_document_count_ = 0;
 }
 
 template <typename StringCollection>
@@ -251,111 +838,190 @@ SearchServer::SearchServer(const StringCollection& stop_words) {
 
 template <typename Execution, typename Predicate>
 std::vector<Document> SearchServer::FindTopDocuments(Execution policy, const std::string_view raw_query,
-                                                     Predicate predicate) const {
-    const Query query = ParseQuery(policy, raw_query);
+                                                     Predicate predicate, int max_result_document_count) const {
+    return FindTopDocuments(policy, PrepareQuery(policy, raw_query), predicate, max_result_document_count);
+}
 
-    // handle exception that could have occured while ParsingQuery
-    if (exception_pointer_in_parse_query_word) {
-        auto temp_exception_holder = exception_pointer_in_parse_query_word;
-        exception_pointer_in_parse_query_word = nullptr;
-        std::rethrow_exception(temp_exception_holder);
+template <typename Execution, typename Predicate>
+std::vector<Document> SearchServer::FindTopDocuments(Execution policy, const PreparedQuery& query,
+                                                     Predicate predicate, int max_result_document_count) const {
+    if (max_result_document_count < 0) {
+        throw std::invalid_argument("negative result document count is not allowed"s);
     }
 
-    std::vector<Document> matched_documents = FindAllDocuments(policy, query);
-
-    std::vector<Document> filtered_documents;
+    using Selector = top_k_selection::TopKSelector<Document, decltype(&IsMoreRelevant)>;
+    const auto max_count = static_cast<size_t>(max_result_document_count);
+    const int64_t document_id_bound = GetDocumentIdBound();
 
-    if (std::is_same_v<Execution, std::execution::sequenced_policy>) {
-        for (const Document& document : matched_documents) {
-            const auto document_status = document_id_to_document_data_.at(document.id).status;
-            const auto document_rating = document_id_to_document_data_.at(document.id).rating;
+    Selector selector(max_count, &IsMoreRelevant);
 
-            if (predicate(document.id, document_status, document_rating)) {
-                filtered_documents.push_back(document);
-            }
+    const auto find_documents = [this, &query, &predicate](int64_t first_document_id, int64_t last_document_id,
+                                                            Selector& range_selector) {
+        if (retrieval_mode_ == RetrievalMode::MAX_SCORE) {
+            FindTopDocumentsWithMaxScore(query, first_document_id, last_document_id, predicate, range_selector);
+        } else {
+            FindAllDocuments(query, first_document_id, last_document_id, predicate, range_selector);
         }
+    };
 
+    if constexpr (std::is_same_v<Execution, std::execution::sequenced_policy>) {
+        find_documents(0, document_id_bound, selector);
     } else {
-        filtered_documents = parallel_copy::CopyIfUnordered(matched_documents, [&](Document document) {
-            const auto document_status = document_id_to_document_data_.at(document.id).status;
-            const auto document_rating = document_id_to_document_data_.at(document.id).rating;
-
-            if (predicate(document.id, document_status, document_rating)) {
-                return true;
-            }
-
-            return false;
+        // every shard owns a document id range with a private accumulator and heap, only the heaps are merged
+        const int shard_count = static_cast<int>(std::max<int64_t>(
+            1, std::min<int64_t>(parallel_scoring_shard_count_, document_id_bound / kMinDocumentIdsPerShard)));
+        const int64_t shard_width = (document_id_bound + shard_count - 1) / shard_count;
+
+        std::vector<Selector> shard_selectors(shard_count, Selector(max_count, &IsMoreRelevant));
+        std::vector<int> shard_indices(shard_count);
+        std::iota(shard_indices.begin(), shard_indices.end(), 0);
+
+        std::for_each(policy, shard_indices.begin(), shard_indices.end(), [&](int shard_index) {
+            const int64_t first_document_id = std::min(shard_index * shard_width, document_id_bound);
+            const int64_t last_document_id = std::min(first_document_id + shard_width, document_id_bound);
+            find_documents(first_document_id, last_document_id, shard_selectors[shard_index]);
         });
-    }
 
-    std::sort(policy, filtered_documents.begin(), filtered_documents.end(),
-              [](const Document& left, const Document& right) {
-                  if (std::abs(left.relevance - right.relevance) < kAccuracy) {
-                      return left.rating > right.rating;
-                  } else {
-                      return left.relevance > right.relevance;
-                  }
-              });
-
-    if (static_cast<int>(filtered_documents.size()) > kMaxResultDocumentCount) {
-        filtered_documents.resize(static_cast<size_t>(kMaxResultDocumentCount));
+        for (const Selector& shard_selector : shard_selectors) {
+            selector.Merge(shard_selector);
+        }
     }
 
-    return filtered_documents;
+    return selector.ExtractSorted();
 }
 
 template <typename Predicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, Predicate predicate) const {
-    return FindTopDocuments(std::execution::seq, raw_query, predicate);
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, Predicate predicate,
+                                                     int max_result_document_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, predicate, max_result_document_count);
 }  // FindTopDocuments
 
 template <typename Execution>
 std::vector<Document> SearchServer::FindTopDocuments(Execution policy, const std::string_view raw_query,
-                                                     const DocumentStatus& desired_status) const {
+                                                     const DocumentStatus& desired_status,
+                                                     int max_result_document_count) const {
     const auto predicate = [desired_status](int, DocumentStatus document_status, int) {
         return document_status == desired_status;
     };
 
-    return FindTopDocuments(policy, raw_query, predicate);
+    if (!result_cache_.IsEnabled()) {
+        return FindTopDocuments(policy, raw_query, predicate, max_result_document_count);
+    }
+
+    const Query query = ParseQuery(policy, raw_query);
+    const std::string key = MakeResultCacheKey(query, desired_status, max_result_document_count);
+    const uint64_t generation = result_cache_.GetGeneration();
+
+    if (auto documents = result_cache_.Find(key)) {
+        return std::move(*documents);
+    }
+
+    auto documents = FindTopDocuments(policy, BindQuery(query), predicate, max_result_document_count);
+    result_cache_.Insert(key, documents, generation);
+
+    return documents;
 }  // FindTopDocuments with status as a second argument
 
+template <typename Predicate>
+std::vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query, Predicate predicate,
+                                                     int max_result_document_count) const {
+    return FindTopDocuments(std::execution::seq, query, predicate, max_result_document_count);
+}
+
 template <typename Execution>
-std::vector<Document> SearchServer::FindAllDocuments(Execution policy, const Query& query) const {
-    static constexpr int kNumberOfBuckets = 50;
-    ConcurrentMap<int, double> document_id_to_relevance_concurrent(kNumberOfBuckets);
+std::vector<Document> SearchServer::FindTopDocuments(Execution policy, const PreparedQuery& query,
+                                                     const DocumentStatus& desired_status,
+                                                     int max_result_document_count) const {
+    const auto predicate = [desired_status](int, DocumentStatus document_status, int) {
+        return document_status == desired_status;
+    };
 
-    std::for_each(std::execution::par, query.plus_words.begin(), query.plus_words.end(), [&](std::string_view word) {
-        if (word_to_document_id_to_term_frequency_.count(word) == 0) {
-            return;
-        }
+    return FindTopDocuments(policy, query, predicate, max_result_document_count);
+}
 
-        const double inverse_document_frequency = ComputeWordInverseDocumentFrequency(word);
+template <typename Predicate, typename Selector>
+void SearchServer::FindAllDocuments(const PreparedQuery& query, int64_t first_document_id, int64_t last_document_id,
+                                    Predicate& predicate, Selector& selector) const {
+    // reused by every query running on this thread, so scoring allocates nothing once warmed up
+    thread_local score_accumulation::ScoreAccumulator accumulator;
 
-        for (const auto& [document_id, term_frequency] : word_to_document_id_to_term_frequency_.at(word)) {
-            document_id_to_relevance_concurrent[document_id].ref_to_value +=
-                term_frequency * inverse_document_frequency;
+    accumulator.Reset(first_document_id, last_document_id, document_ids_.size());
+
+    // calls action(index) for every posting of the list that falls into the range
+    const auto for_each_posting_in_range = [first_document_id, last_document_id](
+                                               const search_server_storage_container::PostingList& posting_list,
+                                               auto action) {
+        const auto& document_ids = posting_list.GetDocumentIds();
+        const auto first = std::lower_bound(document_ids.begin(), document_ids.end(), first_document_id);
+
+        for (auto index = static_cast<size_t>(first - document_ids.begin());
+             index < document_ids.size() && document_ids[index] < last_document_id; ++index) {
+            action(index);
         }
-    });
+    };
 
-    std::for_each(std::execution::par, query.minus_words.begin(), query.minus_words.end(), [&](std::string_view word) {
-        if (word_to_document_id_to_term_frequency_.count(word) == 0) {
+    for (const auto& [term_id, inverse_document_frequency] : query.plus_words_) {
+        const auto& posting_list = posting_lists_[term_id];
+        const auto& document_ids = posting_list.GetDocumentIds();
+        const auto& term_frequencies = posting_list.GetTermFrequencies();
+
+        for_each_posting_in_range(posting_list, [&, inverse_document_frequency = inverse_document_frequency](
+                                                     size_t index) {
+            accumulator.Add(document_ids[index], term_frequencies[index] * inverse_document_frequency);
+        });
+    }
+
+    for (const auto& word : query.minus_words_) {
+        const auto& posting_list = posting_lists_[word.term_id];
+        const auto& document_ids = posting_list.GetDocumentIds();
+
+        for_each_posting_in_range(posting_list, [&](size_t index) { accumulator.Exclude(document_ids[index]); });
+    }
+
+    accumulator.ForEach([&](int document_id, double relevance) {
+        if (removed_documents_.Contains(document_id)) {
             return;
         }
 
-        for (const auto& [document_id, _] : word_to_document_id_to_term_frequency_.at(word)) {
-            document_id_to_relevance_concurrent.Erase(document_id);
+        const DocumentData& document_data = document_id_to_document_data_.at(document_id);
+
+        if (predicate(document_id, document_data.status, document_data.rating)) {
+            selector.Push({document_id, relevance, document_data.rating});
         }
     });
+}  // FindAllDocuments
 
-    std::map<int, double> document_id_to_relevance = document_id_to_relevance_concurrent.BuildOrdinaryMap();
+template <typename Predicate, typename Selector>
+void SearchServer::FindTopDocumentsWithMaxScore(const PreparedQuery& query, int64_t first_document_id,
+                                                int64_t last_document_id, Predicate& predicate,
+                                                Selector& selector) const {
+    // reused by every query running on this thread
+    thread_local std::vector<PostingCursor> cursors;
+    thread_local std::vector<PostingCursor> minus_cursors;
+
+    cursors.clear();
+    for (size_t word_index = 0; word_index < query.plus_words_.size(); ++word_index) {
+        const auto& [term_id, inverse_document_frequency] = query.plus_words_[word_index];
+        cursors.emplace_back(posting_lists_[term_id], inverse_document_frequency, word_index, first_document_id,
+                             last_document_id);
+    }
 
-    std::vector<Document> matched_documents;
-    for (const auto& [document_id, relevance] : document_id_to_relevance) {
-        matched_documents.push_back({document_id, relevance, document_id_to_document_data_.at(document_id).rating});
+    minus_cursors.clear();
+    for (const auto& word : query.minus_words_) {
+        minus_cursors.emplace_back(posting_lists_[word.term_id], 0.0, 0, first_document_id, last_document_id);
     }
 
-    return matched_documents;
-}  // FindAllDocuments
+    max_score_retrieval::FindTopDocuments(
+        cursors, minus_cursors, selector, kAccuracy,
+        [this](int document_id) { return removed_documents_.Contains(document_id); },
+        [&](int document_id, double relevance) {
+            const DocumentData& document_data = document_id_to_document_data_.at(document_id);
+
+            if (predicate(document_id, document_data.status, document_data.rating)) {
+                selector.Push({document_id, relevance, document_data.rating});
+            }
+        });
+}  // FindTopDocumentsWithMaxScore
 
 namespace search_server_helpers {
 
@@ -370,27 +1036,4 @@ void MatchDocuments(const SearchServer& search_server, const std::string_view qu
 
 SearchServer CreateSearchServer(const std::string_view stop_words);
 
-}  // namespace search_server_helpers
-
-namespace parallel_copy {
-
-template <typename Container, typename Predicate>
-std::vector<typename Container::value_type> CopyIfUnordered(const Container& container, Predicate predicate) {
-    std::vector<typename Container::value_type> result;
-    result.reserve(container.size());
-    std::mutex result_mutex;
-    std::for_each(std::execution::par, container.begin(), container.end(),
-                  [predicate, &result_mutex, &result](const auto& value) {
-                      if (predicate(value)) {
-                          typename Container::value_type* destination;
-                          {
-                              std::lock_guard guard(result_mutex);
-                              destination = &result.emplace_back();
-                          }
-                          *destination = value;
-                      }
-                  });
-    return result;
-}
-
-}  // namespace parallel_copy
\ No newline at end of file
+}  // namespace search_server_helpers
\ No newline at end of file
@@ -0,0 +1,401 @@
+#include "search_server_snapshot.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "document_bitmap.h"
+#include "search_server.h"
+
+using namespace std::literals;
+using namespace search_server_snapshot;
+
+uint64_t search_server_snapshot::ComputeChecksum(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+
+    for (size_t offset = 0; offset < size; offset += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + offset, sizeof(uint64_t));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+namespace {
+
+class SectionWriter {
+   public:
+    template <typename T>
+    void WriteArray(const T* values, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        const uint64_t stored_count = count;
+        Append(&stored_count, sizeof(stored_count));
+        Append(values, sizeof(T) * count);
+    }
+
+    template <typename T>
+    void WriteArray(const std::vector<T>& values) {
+        WriteArray(values.data(), values.size());
+    }
+
+    template <typename StringCollection>
+    void WriteStrings(const StringCollection& strings) {
+        std::vector<uint64_t> ends;
+        std::string text;
+
+        for (const auto& string : strings) {
+            text.append(string.data(), string.size());
+            ends.push_back(text.size());
+        }
+
+        WriteArray(ends);
+        WriteArray(text.data(), text.size());
+    }
+
+    void Flush(SectionTag tag, std::ostream& output) const {
+        const SectionHeader header{tag, 0, payload_.size(), ComputeChecksum(payload_.data(), payload_.size())};
+
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        output.write(payload_.data(), static_cast<std::streamsize>(payload_.size()));
+    }
+
+   private:
+    void Append(const void* data, size_t size) {
+        const size_t offset = payload_.size();
+
+        payload_.resize(offset + AlignUp(size), '\0');
+        if (size > 0) {
+            std::memcpy(payload_.data() + offset, data, size);
+        }
+    }
+
+   private:
+    std::vector<char> payload_;
+};
+
+// Payload of a section read from a stream and checked against its checksum
+class SectionBuffer {
+   public:
+    SectionBuffer(SectionTag tag, std::istream& input) {
+        SectionHeader header{};
+
+        if (!input.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            throw std::invalid_argument("snapshot is truncated"s);
+        }
+
+        if (header.tag != tag || header.payload_size % kAlignment != 0) {
+            throw std::invalid_argument("snapshot section is malformed"s);
+        }
+
+        // 64-bit blocks keep every array of the payload aligned. The size is not trusted until the stream backs it,
+        // so the buffer grows a chunk at a time as the payload is actually read
+        const auto block_count = static_cast<size_t>(header.payload_size / sizeof(uint64_t));
+
+        for (size_t read_block_count = 0; read_block_count < block_count;) {
+            const size_t chunk_block_count = std::min(kMaxChunkBlockCount, block_count - read_block_count);
+            blocks_.resize(read_block_count + chunk_block_count);
+
+            if (!input.read(reinterpret_cast<char*>(blocks_.data() + read_block_count),
+                            static_cast<std::streamsize>(chunk_block_count * sizeof(uint64_t)))) {
+                throw std::invalid_argument("snapshot is truncated"s);
+            }
+
+            read_block_count += chunk_block_count;
+        }
+
+        if (ComputeChecksum(GetData(), header.payload_size) != header.checksum) {
+            throw std::invalid_argument("snapshot checksum mismatch"s);
+        }
+    }
+
+    PayloadReader GetReader() const { return {GetData(), blocks_.size() * sizeof(uint64_t)}; }
+
+   private:
+    static constexpr size_t kMaxChunkBlockCount = (size_t{1} << 20) / sizeof(uint64_t);
+
+   private:
+    const char* GetData() const { return reinterpret_cast<const char*>(blocks_.data()); }
+
+   private:
+    std::vector<uint64_t> blocks_;
+};
+
+bool IsValidStatus(DocumentStatus status) {
+    switch (status) {
+        case DocumentStatus::ACTUAL:
+        case DocumentStatus::IRRELEVANT:
+        case DocumentStatus::BANNED:
+        case DocumentStatus::REMOVED:
+            return true;
+    }
+    return false;
+}
+
+template <typename T>
+std::vector<T> ToVector(ArrayView<T> values, size_t first, size_t last) {
+    return std::vector<T>(values.begin() + first, values.begin() + last);
+}
+
+}  // namespace
+
+void SearchServer::SaveSnapshot(std::ostream& output) const {
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order_mark = kByteOrderMark;
+    header.section_count = kSectionCount;
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    {
+        SectionWriter stop_words;
+        stop_words.WriteStrings(stop_words_);
+        stop_words.Flush(SectionTag::STOP_WORDS, output);
+    }
+
+    std::vector<std::string_view> words;
+    words.reserve(words_storage_.Size());
+
+    for (size_t term_id = 0; term_id < words_storage_.Size(); ++term_id) {
+        words.push_back(words_storage_.GetWord(static_cast<TermId>(term_id)));
+    }
+
+    {
+        SectionWriter dictionary;
+        dictionary.WriteStrings(words);
+        dictionary.Flush(SectionTag::DICTIONARY, output);
+    }
+
+    {
+        // lets a reader find a word by binary search instead of building a hash table
+        std::vector<TermId> sorted_term_ids(words.size());
+        std::iota(sorted_term_ids.begin(), sorted_term_ids.end(), TermId{0});
+        std::sort(sorted_term_ids.begin(), sorted_term_ids.end(),
+                  [&words](TermId left, TermId right) { return words[left] < words[right]; });
+
+        SectionWriter lexicon;
+        lexicon.WriteArray(sorted_term_ids);
+        lexicon.Flush(SectionTag::LEXICON, output);
+    }
+
+    {
+        // posting lists of all terms back to back, ends[term_id] is one past the last posting of the term
+        std::vector<uint64_t> ends;
+        std::vector<int> document_ids;
+        std::vector<double> term_frequencies;
+        ends.reserve(posting_lists_.size());
+
+        for (TermId term_id = 0; term_id < posting_lists_.size(); ++term_id) {
+            // removed documents are left out, so a loaded server starts compacted
+            const auto write_postings = [&](const search_server_storage_container::PostingList& posting_list) {
+                document_ids.insert(document_ids.end(), posting_list.GetDocumentIds().begin(),
+                                    posting_list.GetDocumentIds().end());
+                term_frequencies.insert(term_frequencies.end(), posting_list.GetTermFrequencies().begin(),
+                                        posting_list.GetTermFrequencies().end());
+            };
+
+            if (GetDocumentFrequency(term_id) == posting_lists_[term_id].Size()) {
+                write_postings(posting_lists_[term_id]);
+            } else {
+                write_postings(GetLivePostings(term_id));
+            }
+
+            ends.push_back(document_ids.size());
+        }
+
+        SectionWriter postings;
+        postings.WriteArray(ends);
+        postings.WriteArray(document_ids);
+        postings.WriteArray(term_frequencies);
+        postings.Flush(SectionTag::POSTINGS, output);
+    }
+
+    {
+        std::vector<int> document_ids;
+        std::vector<int> ratings;
+        std::vector<DocumentStatus> statuses;
+        std::vector<uint64_t> ends;
+        std::vector<TermId> term_ids;
+        std::vector<double> frequencies;
+
+        for (const auto& [document_id, document_data] : document_id_to_document_data_) {
+            document_ids.push_back(document_id);
+            ratings.push_back(document_data.rating);
+            statuses.push_back(document_data.status);
+
+            for (const auto& [term_id, frequency] : document_data.term_frequencies) {
+                term_ids.push_back(term_id);
+                frequencies.push_back(frequency);
+            }
+            ends.push_back(term_ids.size());
+        }
+
+        SectionWriter documents;
+        documents.WriteArray(document_ids);
+        documents.WriteArray(ratings);
+        documents.WriteArray(statuses);
+        documents.WriteArray(ends);
+        documents.WriteArray(term_ids);
+        documents.WriteArray(frequencies);
+        documents.Flush(SectionTag::DOCUMENTS, output);
+    }
+
+    if (!output) {
+        throw std::invalid_argument("failed to write snapshot"s);
+    }
+}  // SaveSnapshot
+
+SearchServer SearchServer::LoadSnapshot(std::istream& input) {
+    SnapshotHeader header{};
+
+    if (!input.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::invalid_argument("not a search server snapshot"s);
+    }
+
+    if (header.version != kVersion || header.byte_order_mark != kByteOrderMark ||
+        header.section_count != kSectionCount) {
+        throw std::invalid_argument("unsupported snapshot version"s);
+    }
+
+    SearchServer server;
+
+    {
+        const SectionBuffer section(SectionTag::STOP_WORDS, input);
+        const StringsView stop_words = section.GetReader().ReadStrings();
+
+        for (size_t index = 0; index < stop_words.size(); ++index) {
+            server.stop_words_.emplace_hint(server.stop_words_.end(), stop_words[index]);
+        }
+    }
+
+    {
+        const SectionBuffer section(SectionTag::DICTIONARY, input);
+        const StringsView words = section.GetReader().ReadStrings();
+
+        server.words_storage_.Reserve(words.size());
+        for (size_t index = 0; index < words.size(); ++index) {
+            server.words_storage_.Insert(words[index]);
+        }
+
+        if (server.words_storage_.Size() != words.size()) {
+            throw std::invalid_argument("snapshot dictionary has repeating words"s);
+        }
+    }
+
+    const size_t term_count = server.words_storage_.Size();
+
+    {
+        // the server keeps its own hash table, the lexicon is only checked
+        const SectionBuffer section(SectionTag::LEXICON, input);
+
+        if (section.GetReader().ReadArray<TermId>().size() != term_count) {
+            throw std::invalid_argument("snapshot lexicon is malformed"s);
+        }
+    }
+
+    {
+        const SectionBuffer section(SectionTag::POSTINGS, input);
+        PayloadReader reader = section.GetReader();
+        const auto ends = reader.ReadArray<uint64_t>();
+        const auto document_ids = reader.ReadArray<int>();
+        const auto term_frequencies = reader.ReadArray<double>();
+
+        if (ends.size() != term_count || document_ids.size() != term_frequencies.size() ||
+            (!ends.empty() && ends.back() != document_ids.size())) {
+            throw std::invalid_argument("snapshot postings are malformed"s);
+        }
+
+        server.posting_lists_.reserve(term_count);
+
+        uint64_t begin = 0;
+        for (const uint64_t end : ends) {
+            if (end < begin || end > document_ids.size()) {
+                throw std::invalid_argument("snapshot postings are malformed"s);
+            }
+
+            // ids of a list are checked against the documents once those are read
+            if (std::adjacent_find(document_ids.begin() + begin, document_ids.begin() + end, std::greater_equal<>{}) !=
+                document_ids.begin() + end) {
+                throw std::invalid_argument("snapshot postings are malformed"s);
+            }
+
+            server.posting_lists_.emplace_back(ToVector(document_ids, begin, end),
+                                               ToVector(term_frequencies, begin, end));
+            begin = end;
+        }
+    }
+
+    {
+        const SectionBuffer section(SectionTag::DOCUMENTS, input);
+        PayloadReader reader = section.GetReader();
+        const auto document_ids = reader.ReadArray<int>();
+        const auto ratings = reader.ReadArray<int>();
+        const auto statuses = reader.ReadArray<DocumentStatus>();
+        const auto ends = reader.ReadArray<uint64_t>();
+        const auto term_ids = reader.ReadArray<TermId>();
+        const auto frequencies = reader.ReadArray<double>();
+
+        const size_t document_count = document_ids.size();
+
+        if (ratings.size() != document_count || statuses.size() != document_count ||
+            ends.size() != document_count || term_ids.size() != frequencies.size()) {
+            throw std::invalid_argument("snapshot documents are malformed"s);
+        }
+
+        uint64_t begin = 0;
+        for (size_t index = 0; index < document_count; ++index) {
+            const uint64_t end = ends[index];
+
+            if (end < begin || end > term_ids.size() || (index > 0 && document_ids[index - 1] >= document_ids[index]) ||
+                !IsValidStatus(statuses[index])) {
+                throw std::invalid_argument("snapshot documents are malformed"s);
+            }
+
+            DocumentData document_data{ratings[index], statuses[index], {}};
+            document_data.term_frequencies.reserve(end - begin);
+
+            for (uint64_t position = begin; position < end; ++position) {
+                if (term_ids[position] >= term_count) {
+                    throw std::invalid_argument("snapshot documents are malformed"s);
+                }
+                document_data.term_frequencies.push_back({term_ids[position], frequencies[position]});
+            }
+
+            server.document_id_to_document_data_.emplace_hint(server.document_id_to_document_data_.end(),
+                                                               document_ids[index], std::move(document_data));
+            server.document_ids_.emplace_hint(server.document_ids_.end(), document_ids[index]);
+            begin = end;
+        }
+
+        // a posting of an unknown document would only fail once a query scores it. The loaded ids are marked once,
+        // so every posting is checked by a lookup
+        search_server_storage_container::DocumentBitmap known_documents;
+        for (const int document_id : document_ids) {
+            known_documents.Insert(document_id);
+        }
+
+        for (const auto& posting_list : server.posting_lists_) {
+            for (const int document_id : posting_list.GetDocumentIds()) {
+                if (!known_documents.Contains(document_id)) {
+                    throw std::invalid_argument("snapshot postings are malformed"s);
+                }
+            }
+        }
+    }
+
+    server.OnDocumentsChanged();
+
+    return server;
+}  // LoadSnapshot
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Snapshot layout, all integers in the byte order of the machine that wrote it:
+//
+//   SnapshotHeader
+//   SectionHeader + payload    stop words, sorted
+//   SectionHeader + payload    dictionary, words in term id order
+//   SectionHeader + payload    lexicon, term ids in the alphabetical order of their words
+//   SectionHeader + payload    postings
+//   SectionHeader + payload    documents
+//
+// A payload is a sequence of flat arrays, each preceded by its element count and padded to 8 bytes. Headers are
+// multiples of 8 bytes too, so every array of a snapshot read into (or mapped at) an aligned address is aligned and
+// can be used in place
+namespace search_server_snapshot {
+
+constexpr char kMagic[8] = {'S', 'R', 'C', 'H', 'S', 'N', 'A', 'P'};
+constexpr uint32_t kVersion = 2;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+enum class SectionTag : uint32_t {
+    STOP_WORDS = 1,
+    DICTIONARY = 2,
+    LEXICON = 3,
+    POSTINGS = 4,
+    DOCUMENTS = 5,
+};
+
+constexpr uint32_t kSectionCount = 5;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint32_t section_count;
+    uint32_t reserved;
+};
+
+struct SectionHeader {
+    SectionTag tag;
+    uint32_t reserved;
+    uint64_t payload_size;
+    uint64_t checksum;
+};
+
+constexpr size_t kAlignment = 8;
+
+inline size_t AlignUp(size_t size) { return (size + kAlignment - 1) / kAlignment * kAlignment; }
+
+// FNV-1a over 64-bit words, payloads are always a whole number of words
+uint64_t ComputeChecksum(const char* data, size_t size);
+
+// Read-only view of an array stored in a payload
+template <typename T>
+class ArrayView {
+   public:
+    ArrayView() = default;
+
+    ArrayView(const T* data, size_t size) : data_(data), size_(size) {}
+
+    const T* begin() const { return data_; }
+
+    const T* end() const { return data_ + size_; }
+
+    const T* data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    const T& operator[](size_t index) const { return data_[index]; }
+
+    const T& back() const { return data_[size_ - 1]; }
+
+   private:
+    const T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Strings stored as an array of end offsets followed by their concatenated text
+class StringsView {
+   public:
+    StringsView() = default;
+
+    StringsView(ArrayView<uint64_t> ends, ArrayView<char> text) : ends_(ends), text_(text) {}
+
+    size_t size() const { return ends_.size(); }
+
+    // Throws std::invalid_argument if there is no such string or its offsets are inconsistent
+    std::string_view operator[](size_t index) const {
+        if (index >= ends_.size()) {
+            throw std::invalid_argument("snapshot strings are malformed");
+        }
+
+        const uint64_t begin = index == 0 ? 0 : ends_[index - 1];
+        const uint64_t end = ends_[index];
+
+        if (end < begin || end > text_.size()) {
+            throw std::invalid_argument("snapshot strings are malformed");
+        }
+
+        return {text_.data() + begin, static_cast<size_t>(end - begin)};
+    }
+
+   private:
+    ArrayView<uint64_t> ends_;
+    ArrayView<char> text_;
+};
+
+// Walks the arrays of a payload in the order they were written. Only sizes are checked, the arrays are not touched,
+// so reading a mapped payload does not page it in
+class PayloadReader {
+   public:
+    PayloadReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    // Throws std::invalid_argument if the array does not fit into the payload
+    template <typename T>
+    ArrayView<T> ReadArray() {
+        const uint64_t count = *reinterpret_cast<const uint64_t*>(Take(sizeof(uint64_t)));
+
+        if (count > (size_ - offset_) / sizeof(T)) {
+            throw std::invalid_argument("snapshot section is malformed");
+        }
+
+        const auto size = static_cast<size_t>(count) * sizeof(T);
+
+        return {reinterpret_cast<const T*>(Take(size)), static_cast<size_t>(count)};
+    }
+
+    StringsView ReadStrings() {
+        const auto ends = ReadArray<uint64_t>();
+        const auto text = ReadArray<char>();
+
+        if (!ends.empty() && ends.back() != text.size()) {
+            throw std::invalid_argument("snapshot strings are malformed");
+        }
+
+        return {ends, text};
+    }
+
+   private:
+    const char* Take(size_t size) {
+        if (size > size_ - offset_) {
+            throw std::invalid_argument("snapshot section is malformed");
+        }
+
+        const char* result = data_ + offset_;
+        offset_ = std::min(size_, offset_ + AlignUp(size));
+
+        return result;
+    }
+
+   private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+};
+
+}  // namespace search_server_snapshot
@@ -0,0 +1,480 @@
+#include "segmented_search_server.h"
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <utility>
+
+#include "string_processing.h"
+
+using namespace std::literals;
+
+SegmentedSearchServer::SegmentedSearchServer(const std::string& stop_words, int segment_capacity)
+    : stop_words_(stop_words), segment_capacity_(segment_capacity), query_parser_(stop_words) {
+    if (segment_capacity <= 0) {
+        throw std::invalid_argument("segment capacity must be positive"s);
+    }
+
+    auto version = std::make_unique<IndexVersion>();
+    version->buffer = std::make_shared<DocumentBuffer>(static_cast<size_t>(segment_capacity_));
+    version->removed_buffer_positions = std::make_shared<const std::set<size_t>>();
+    current_version_ = version.release();
+
+    merge_thread_ = std::thread([this]() { RunMerges(); });
+}
+
+SegmentedSearchServer::~SegmentedSearchServer() {
+    {
+        std::lock_guard lock(merge_request_mutex_);
+        is_stopping_ = true;
+    }
+
+    merge_requested_.notify_one();
+    merge_thread_.join();
+
+    delete current_version_.load();
+}
+
+void SegmentedSearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status,
+                                        const std::vector<int>& ratings) {
+    // tokenized before taking the lock, so writers only queue up to publish
+    BufferedDocument buffered_document = MakeBufferedDocument(document_id, document, status, ratings);
+
+    {
+        std::lock_guard lock(write_mutex_);
+
+        if (live_document_ids_.count(document_id) > 0) {
+            throw std::invalid_argument("repeating ids are not allowed"s);
+        }
+
+        auto version = std::make_unique<IndexVersion>(GetLatestVersion());
+
+        // no version sees this slot yet
+        (*version->buffer)[version->buffered_document_count] = std::move(buffered_document);
+        ++version->buffered_document_count;
+        ++version->document_count;
+        live_document_ids_.insert(document_id);
+
+        const bool is_buffer_full = version->buffered_document_count == version->buffer->size();
+
+        if (is_buffer_full) {
+            SealBuffer(*version);
+        }
+
+        Publish(std::move(version));
+
+        if (!is_buffer_full) {
+            return;
+        }
+    }
+
+    RequestMerge();
+}
+
+void SegmentedSearchServer::RemoveDocument(int document_id) {
+    {
+        std::lock_guard lock(write_mutex_);
+
+        if (live_document_ids_.erase(document_id) == 0) {
+            return;
+        }
+
+        auto version = std::make_unique<IndexVersion>(GetLatestVersion());
+        --version->document_count;
+
+        // a removed id can be added again, so the buffer may hold it more than once, only once live
+        for (size_t position = 0; position < version->buffered_document_count; ++position) {
+            if ((*version->buffer)[position].id == document_id && IsBufferedDocumentLive(*version, position)) {
+                auto removed_positions = std::make_shared<std::set<size_t>>(*version->removed_buffer_positions);
+                removed_positions->insert(position);
+                version->removed_buffer_positions = std::move(removed_positions);
+
+                Publish(std::move(version));
+                return;
+            }
+        }
+
+        // a live document not in the buffer is in exactly one sealed segment
+        const auto it = std::find_if(version->sealed_segments.begin(), version->sealed_segments.end(),
+                                     [document_id](const SealedSegment& segment) {
+                                         return segment.index->document_id_to_document_data_.count(document_id) > 0 &&
+                                                segment.tombstones->document_ids.count(document_id) == 0;
+                                     });
+
+        auto tombstones = std::make_shared<Tombstones>(*it->tombstones);
+        tombstones->document_ids.insert(document_id);
+
+        for (const auto& [term_id, frequency] : it->index->GetTermFrequencies(document_id)) {
+            ++tombstones->document_frequencies[term_id];
+        }
+
+        it->tombstones = std::move(tombstones);
+
+        Publish(std::move(version));
+    }
+
+    RequestMerge();
+}
+
+int SegmentedSearchServer::GetDocumentCount() const {
+    const auto guard = epochs_.Pin();
+
+    return current_version_.load()->document_count;
+}
+
+size_t SegmentedSearchServer::GetSegmentCount() const {
+    const auto guard = epochs_.Pin();
+    const IndexVersion& version = *current_version_.load();
+
+    return version.sealed_segments.size() +
+           (version.buffered_document_count > version.removed_buffer_positions->size() ? 1 : 0);
+}
+
+void SegmentedSearchServer::Compact() {
+    {
+        std::lock_guard lock(write_mutex_);
+
+        auto version = std::make_unique<IndexVersion>(GetLatestVersion());
+        SealBuffer(*version);
+        Publish(std::move(version));
+    }
+
+    std::lock_guard merge_lock(merge_mutex_);
+
+    std::vector<SealedSegment> segments;
+
+    {
+        std::lock_guard lock(write_mutex_);
+        segments = GetLatestVersion().sealed_segments;
+    }
+
+    if (segments.empty() || (segments.size() == 1 && segments.front().tombstones->document_ids.empty())) {
+        return;
+    }
+
+    ReplaceSegments(segments, MergeSegments(segments));
+}
+
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(const std::string_view raw_query,
+                                                              const DocumentStatus& desired_status,
+                                                              int max_result_document_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, desired_status, max_result_document_count);
+}
+
+int SegmentedSearchServer::GetTier(const SealedSegment& segment) const {
+    int tier = 0;
+
+    for (size_t tier_size = static_cast<size_t>(segment_capacity_) * kMergeFactor;
+         static_cast<size_t>(segment.index->GetDocumentCount()) >= tier_size; tier_size *= kMergeFactor) {
+        ++tier;
+    }
+
+    return tier;
+}
+
+SegmentedSearchServer::BufferedDocument SegmentedSearchServer::MakeBufferedDocument(
+    int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) const {
+    if (document_id < 0) {
+        throw std::invalid_argument("negative ids are not allowed"s);
+    }
+
+    std::vector<std::string_view> words;
+
+    if (!string_processing::SplitIntoWordsValidated(document, words)) {
+        throw std::invalid_argument("word in document contains unaccaptable symbol"s);
+    }
+
+    query_parser_.RemoveStopWords(words);
+    std::sort(words.begin(), words.end());
+
+    BufferedDocument buffered_document{document_id, status, SearchServer::ComputeAverageRating(ratings),
+                                       std::string(document), ratings, {}, {}};
+
+    buffered_document.words.reserve(words.size());
+    buffered_document.term_frequencies.reserve(words.size());
+
+    // added once per occurrence, as SearchServer counts them
+    const double inverse_word_count = 1.0 / static_cast<double>(words.size());
+
+    for (const std::string_view word : words) {
+        if (!buffered_document.words.empty() && buffered_document.words.back() == word) {
+            buffered_document.term_frequencies.back() += inverse_word_count;
+        } else {
+            buffered_document.words.emplace_back(word);
+            buffered_document.term_frequencies.push_back(inverse_word_count);
+        }
+    }
+
+    return buffered_document;
+}
+
+bool SegmentedSearchServer::IsBufferedDocumentLive(const IndexVersion& version, size_t position) {
+    return version.removed_buffer_positions->count(position) == 0;
+}
+
+std::vector<SegmentedSearchServer::ScoredWord> SegmentedSearchServer::ScorePlusWords(
+    const IndexVersion& version, const SearchServer::Query& query) {
+    std::vector<ScoredWord> plus_words;
+    plus_words.reserve(query.plus_words.size());
+
+    for (const std::string_view word : query.plus_words) {
+        size_t document_frequency = 0;
+
+        for (size_t position = 0; position < version.buffered_document_count; ++position) {
+            const auto& words = (*version.buffer)[position].words;
+
+            if (IsBufferedDocumentLive(version, position) && std::binary_search(words.begin(), words.end(), word)) {
+                ++document_frequency;
+            }
+        }
+
+        for (const SealedSegment& segment : version.sealed_segments) {
+            if (const auto term_id = segment.index->words_storage_.Find(word)) {
+                document_frequency += segment.index->GetDocumentFrequency(*term_id);
+
+                const auto& removed_frequencies = segment.tombstones->document_frequencies;
+                if (const auto it = removed_frequencies.find(*term_id); it != removed_frequencies.end()) {
+                    document_frequency -= static_cast<size_t>(it->second);
+                }
+            }
+        }
+
+        plus_words.push_back(
+            {word, document_frequency == 0
+                       ? 0.0
+                       : std::log(static_cast<double>(version.document_count) / document_frequency)});
+    }
+
+    return plus_words;
+}
+
+std::vector<SegmentedSearchServer::PreparedSegment> SegmentedSearchServer::PrepareSegments(
+    const IndexVersion& version, const SearchServer::Query& query, const std::vector<ScoredWord>& plus_words) {
+    // plus words come sorted, as the query keeps them
+    const auto find_inverse_document_frequency = [&plus_words](std::string_view word) {
+        return std::lower_bound(plus_words.begin(), plus_words.end(), word,
+                                [](const ScoredWord& scored_word, std::string_view value) {
+                                    return scored_word.word < value;
+                                })
+            ->inverse_document_frequency;
+    };
+
+    std::vector<PreparedSegment> prepared_segments;
+    prepared_segments.reserve(version.sealed_segments.size());
+
+    for (const SealedSegment& segment : version.sealed_segments) {
+        SearchServer::PreparedQuery prepared_query = segment.index->BindQuery(query);
+
+        for (auto& word : prepared_query.plus_words_) {
+            word.inverse_document_frequency = find_inverse_document_frequency(segment.index->GetWord(word.term_id));
+        }
+
+        prepared_segments.push_back({&segment, std::move(prepared_query)});
+    }
+
+    return prepared_segments;
+}
+
+void SegmentedSearchServer::SealBuffer(IndexVersion& version) const {
+    if (version.buffered_document_count == 0) {
+        return;
+    }
+
+    std::vector<SearchServer::NewDocument> documents;
+
+    for (size_t position = 0; position < version.buffered_document_count; ++position) {
+        if (IsBufferedDocumentLive(version, position)) {
+            const BufferedDocument& document = (*version.buffer)[position];
+            documents.push_back({document.id, document.text, document.status, document.ratings});
+        }
+    }
+
+    if (!documents.empty()) {
+        auto segment = std::make_shared<SearchServer>(stop_words_);
+        segment->AddDocuments(documents);
+        version.sealed_segments.push_back({std::move(segment), std::make_shared<const Tombstones>()});
+    }
+
+    // queries of older versions still read the old buffer
+    version.buffer = std::make_shared<DocumentBuffer>(static_cast<size_t>(segment_capacity_));
+    version.buffered_document_count = 0;
+    version.removed_buffer_positions = std::make_shared<const std::set<size_t>>();
+}
+
+std::vector<SegmentedSearchServer::SealedSegment> SegmentedSearchServer::PickSegmentsToMerge() {
+    std::lock_guard lock(write_mutex_);
+    const IndexVersion& version = GetLatestVersion();
+
+    for (const SealedSegment& segment : version.sealed_segments) {
+        const size_t removed_document_count = segment.tombstones->document_ids.size();
+
+        if (removed_document_count > 0 &&
+            removed_document_count * 2 >= static_cast<size_t>(segment.index->GetDocumentCount())) {
+            return {segment};
+        }
+    }
+
+    std::map<int, std::vector<SealedSegment>> segments_by_tier;
+
+    for (const SealedSegment& segment : version.sealed_segments) {
+        segments_by_tier[GetTier(segment)].push_back(segment);
+    }
+
+    // small segments first, they are cheap to merge and there are more of them
+    for (auto& [tier, segments] : segments_by_tier) {
+        if (segments.size() >= kMergeFactor) {
+            segments.resize(kMergeFactor);
+            return segments;
+        }
+    }
+
+    return {};
+}
+
+SegmentedSearchServer::SealedSegment SegmentedSearchServer::MergeSegments(
+    const std::vector<SealedSegment>& segments) const {
+    constexpr TermId kUnknownTermId = std::numeric_limits<TermId>::max();
+
+    // live documents of all segments in increasing id order, so every posting is appended
+    std::vector<std::pair<int, size_t>> documents;
+
+    for (size_t segment_index = 0; segment_index < segments.size(); ++segment_index) {
+        const SealedSegment& segment = segments[segment_index];
+
+        for (const int document_id : *segment.index) {
+            if (segment.tombstones->document_ids.count(document_id) == 0) {
+                documents.emplace_back(document_id, segment_index);
+            }
+        }
+    }
+
+    std::sort(documents.begin(), documents.end());
+
+    auto merged = std::make_shared<SearchServer>(stop_words_);
+
+    // term ids of every segment translated to term ids of the merged segment on first use
+    std::vector<std::vector<TermId>> merged_term_ids(segments.size());
+
+    for (size_t segment_index = 0; segment_index < segments.size(); ++segment_index) {
+        merged_term_ids[segment_index].assign(segments[segment_index].index->words_storage_.Size(), kUnknownTermId);
+    }
+
+    for (const auto& [document_id, segment_index] : documents) {
+        const SearchServer& index = *segments[segment_index].index;
+        const SearchServer::DocumentData& document_data = index.document_id_to_document_data_.at(document_id);
+
+        SearchServer::DocumentData merged_document_data{document_data.rating, document_data.status, {}};
+        merged_document_data.term_frequencies.reserve(document_data.term_frequencies.size());
+
+        for (const auto& [term_id, frequency] : document_data.term_frequencies) {
+            TermId& merged_term_id = merged_term_ids[segment_index][term_id];
+
+            if (merged_term_id == kUnknownTermId) {
+                merged_term_id = merged->words_storage_.Insert(index.words_storage_.GetWord(term_id));
+            }
+
+            merged_document_data.term_frequencies.push_back({merged_term_id, frequency});
+        }
+
+        std::sort(merged_document_data.term_frequencies.begin(), merged_document_data.term_frequencies.end(),
+                  [](const auto& left, const auto& right) { return left.term_id < right.term_id; });
+
+        merged->posting_lists_.resize(merged->words_storage_.Size());
+
+        for (const auto& [term_id, frequency] : merged_document_data.term_frequencies) {
+            merged->posting_lists_[term_id].Add(document_id, frequency);
+        }
+
+        merged->document_ids_.emplace_hint(merged->document_ids_.end(), document_id);
+        merged->document_id_to_document_data_.emplace_hint(merged->document_id_to_document_data_.end(), document_id,
+                                                          std::move(merged_document_data));
+    }
+
+    merged->OnDocumentsChanged();
+
+    return {std::move(merged), std::make_shared<const Tombstones>()};
+}
+
+void SegmentedSearchServer::ReplaceSegments(const std::vector<SealedSegment>& merged_segments, SealedSegment result) {
+    std::lock_guard lock(write_mutex_);
+
+    auto version = std::make_unique<IndexVersion>(GetLatestVersion());
+    auto& sealed_segments = version->sealed_segments;
+    auto tombstones = std::make_shared<Tombstones>();
+
+    for (const SealedSegment& merged_segment : merged_segments) {
+        const auto it = std::find_if(sealed_segments.begin(), sealed_segments.end(),
+                                     [&merged_segment](const SealedSegment& segment) {
+                                         return segment.index == merged_segment.index;
+                                     });
+
+        // documents removed while the merge ran are still in the result
+        for (const int document_id : it->tombstones->document_ids) {
+            if (merged_segment.tombstones->document_ids.count(document_id) == 0) {
+                tombstones->document_ids.insert(document_id);
+
+                for (const auto& [term_id, frequency] : result.index->GetTermFrequencies(document_id)) {
+                    ++tombstones->document_frequencies[term_id];
+                }
+            }
+        }
+
+        sealed_segments.erase(it);
+    }
+
+    result.tombstones = std::move(tombstones);
+
+    if (result.index->GetDocumentCount() > 0) {
+        sealed_segments.push_back(std::move(result));
+    }
+
+    Publish(std::move(version));
+}
+
+const SegmentedSearchServer::IndexVersion& SegmentedSearchServer::GetLatestVersion() const {
+    // only writers store the pointer, and they hold the lock
+    return *current_version_.load();
+}
+
+void SegmentedSearchServer::Publish(std::unique_ptr<IndexVersion> version) {
+    const IndexVersion* previous_version = current_version_.exchange(version.release());
+
+    epochs_.Retire([previous_version]() { delete previous_version; });
+}
+
+void SegmentedSearchServer::RequestMerge() {
+    {
+        std::lock_guard lock(merge_request_mutex_);
+        has_merge_request_ = true;
+    }
+
+    merge_requested_.notify_one();
+}
+
+void SegmentedSearchServer::RunMerges() {
+    while (true) {
+        {
+            std::unique_lock lock(merge_request_mutex_);
+            merge_requested_.wait(lock, [this]() { return has_merge_request_ || is_stopping_; });
+
+            if (is_stopping_) {
+                return;
+            }
+
+            has_merge_request_ = false;
+        }
+
+        // one merge can make room for another, e.g. four merged segments make a segment of the next tier
+        while (!is_stopping_) {
+            std::lock_guard merge_lock(merge_mutex_);
+
+            const std::vector<SealedSegment> segments = PickSegmentsToMerge();
+
+            if (segments.empty()) {
+                break;
+            }
+
+            ReplaceSegments(segments, MergeSegments(segments));
+        }
+    }
+}
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <execution>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "document.h"
+#include "epoch_reclamation.h"
+#include "search_server.h"
+#include "top_k_selector.h"
+
+// Search server split into segments, LSM style. New documents go to a small append-only buffer, which is sealed into
+// an immutable segment once it holds segment_capacity documents. A background thread merges sealed segments of
+// similar size, so their number stays logarithmic in the index size, and drops removed documents while doing so.
+// Queries never wait for writers: the index is an immutable version, a query pins the version current when it starts
+// and a writer publishes the next version with a pointer swap. Versions share everything that did not change, and a
+// replaced version is freed by epoch-based reclamation once no query can hold it. Writers are serialized.
+// Documents are scored with IDF over the whole index, results are the same as of a single SearchServer
+class SegmentedSearchServer {
+   public:
+    // The buffer is scanned by every query, so it is kept small
+    static constexpr int kDefaultSegmentCapacity = 1024;
+
+    // Number of sealed segments of one size tier that are merged together
+    static constexpr size_t kMergeFactor = 4;
+
+    explicit SegmentedSearchServer(const std::string& stop_words, int segment_capacity = kDefaultSegmentCapacity);
+
+    SegmentedSearchServer(const SegmentedSearchServer&) = delete;
+    SegmentedSearchServer& operator=(const SegmentedSearchServer&) = delete;
+
+    // Stops the merge thread, a merge in progress is finished first. No query may be running
+    ~SegmentedSearchServer();
+
+   public:
+    void AddDocument(int document_id, const std::string_view document, DocumentStatus status,
+                     const std::vector<int>& ratings);
+
+    // A document of a sealed segment is hidden at once and dropped from memory by the next merge of its segment
+    void RemoveDocument(int document_id);
+
+    int GetDocumentCount() const;
+
+    // Sealed segments, plus the buffer if it holds documents
+    size_t GetSegmentCount() const;
+
+    // Seals the buffer and merges all segments into one, waits for it to finish
+    void Compact();
+
+    template <typename Predicate>
+    std::vector<Document> FindTopDocuments(
+        const std::string_view raw_query, Predicate predicate,
+        int max_result_document_count = SearchServer::kDefaultMaxResultDocumentCount) const;
+
+    std::vector<Document> FindTopDocuments(
+        const std::string_view raw_query, const DocumentStatus& desired_status = DocumentStatus::ACTUAL,
+        int max_result_document_count = SearchServer::kDefaultMaxResultDocumentCount) const;
+
+    // Sealed segments are searched concurrently under a parallel policy
+    template <typename Execution, typename Predicate>
+    std::vector<Document> FindTopDocuments(
+        Execution policy, const std::string_view raw_query, Predicate predicate,
+        int max_result_document_count = SearchServer::kDefaultMaxResultDocumentCount) const;
+
+    template <typename Execution>
+    std::vector<Document> FindTopDocuments(
+        Execution policy, const std::string_view raw_query, const DocumentStatus& desired_status,
+        int max_result_document_count = SearchServer::kDefaultMaxResultDocumentCount) const;
+
+   private:
+    using TermId = SearchServer::TermId;
+
+    // Documents removed from a sealed segment and how many of them contain each term of the segment
+    struct Tombstones {
+        std::set<int> document_ids;
+        std::unordered_map<TermId, int> document_frequencies;
+    };
+
+    // Tombstones are copied on write, so a version holding a segment keeps a consistent view of it
+    struct SealedSegment {
+        std::shared_ptr<const SearchServer> index;
+        std::shared_ptr<const Tombstones> tombstones;
+    };
+
+    struct BufferedDocument {
+        int id = 0;
+        DocumentStatus status = DocumentStatus::ACTUAL;
+        int rating = 0;
+        // kept to seal the document into a segment
+        std::string text;
+        std::vector<int> ratings;
+        // distinct words without stop words, sorted, and their term frequencies
+        std::vector<std::string> words;
+        std::vector<double> term_frequencies;
+    };
+
+    // Documents not sealed yet. Slots are allocated up front and a published document never changes, so the writer
+    // fills the next slot while queries read the ones before it
+    using DocumentBuffer = std::vector<BufferedDocument>;
+
+    struct IndexVersion {
+        std::vector<SealedSegment> sealed_segments;
+        std::shared_ptr<DocumentBuffer> buffer;
+        // the version sees this many documents of the buffer
+        size_t buffered_document_count = 0;
+        // positions of removed documents in the buffer
+        std::shared_ptr<const std::set<size_t>> removed_buffer_positions;
+        int document_count = 0;
+    };
+
+    // A plus word of the query with IDF over all live documents of a version
+    struct ScoredWord {
+        std::string_view word;
+        double inverse_document_frequency = 0.0;
+    };
+
+    struct PreparedSegment {
+        const SealedSegment* segment = nullptr;
+        SearchServer::PreparedQuery query;
+    };
+
+    using Selector = top_k_selection::TopKSelector<Document, decltype(&SearchServer::IsMoreRelevant)>;
+
+   private:
+    // Size tier of a segment: segments of one tier differ in size less than kMergeFactor times
+    int GetTier(const SealedSegment& segment) const;
+
+    // Tokenizes and checks the document the way SearchServer::AddDocument does
+    BufferedDocument MakeBufferedDocument(int document_id, const std::string_view document, DocumentStatus status,
+                                          const std::vector<int>& ratings) const;
+
+    static bool IsBufferedDocumentLive(const IndexVersion& version, size_t position);
+
+    // Plus words in query order, a word left only in removed documents gets IDF 0: it can match nothing
+    static std::vector<ScoredWord> ScorePlusWords(const IndexVersion& version, const SearchServer::Query& query);
+
+    // Scores the live buffered documents, pushing those passing the predicate to selector
+    template <typename Predicate>
+    static void FindBufferedDocuments(const IndexVersion& version, const SearchServer::Query& query,
+                                      const std::vector<ScoredWord>& plus_words, Predicate& predicate,
+                                      Selector& selector);
+
+    // Binds the parsed query to every sealed segment, plus words get the IDF of plus_words
+    static std::vector<PreparedSegment> PrepareSegments(const IndexVersion& version, const SearchServer::Query& query,
+                                                        const std::vector<ScoredWord>& plus_words);
+
+    // Moves the live buffered documents to a new sealed segment and starts an empty buffer
+    void SealBuffer(IndexVersion& version) const;
+
+    // Picks segments worth merging: kMergeFactor segments of one tier, or one segment that lost half its documents
+    std::vector<SealedSegment> PickSegmentsToMerge();
+
+    // Live documents of the segments as a new segment
+    SealedSegment MergeSegments(const std::vector<SealedSegment>& segments) const;
+
+    // Swaps merged segments for the result, keeping documents removed while the merge ran removed
+    void ReplaceSegments(const std::vector<SealedSegment>& merged_segments, SealedSegment result);
+
+    // The version writers build on, requires write_mutex_
+    const IndexVersion& GetLatestVersion() const;
+
+    // Makes the version current and retires the one it replaces, requires write_mutex_
+    void Publish(std::unique_ptr<IndexVersion> version);
+
+    void RequestMerge();
+
+    void RunMerges();
+
+   private:
+    const std::string stop_words_;
+    const int segment_capacity_;
+
+    // parses queries, holds no documents
+    const SearchServer query_parser_;
+
+    mutable epoch_reclamation::EpochManager epochs_;
+    std::atomic<const IndexVersion*> current_version_ = nullptr;
+
+    // serializes writers, queries never take it
+    std::mutex write_mutex_;
+    std::unordered_set<int> live_document_ids_;
+
+    // one merge at a time, by the merge thread or Compact
+    std::mutex merge_mutex_;
+
+    std::mutex merge_request_mutex_;
+    std::condition_variable merge_requested_;
+    bool has_merge_request_ = false;
+    std::atomic<bool> is_stopping_ = false;
+
+    std::thread merge_thread_;
+};
+
+template <typename Predicate>
+void SegmentedSearchServer::FindBufferedDocuments(const IndexVersion& version, const SearchServer::Query& query,
+                                                  const std::vector<ScoredWord>& plus_words, Predicate& predicate,
+                                                  Selector& selector) {
+    for (size_t position = 0; position < version.buffered_document_count; ++position) {
+        if (!IsBufferedDocumentLive(version, position)) {
+            continue;
+        }
+
+        const BufferedDocument& document = (*version.buffer)[position];
+
+        // index of the word in the document, or -1
+        const auto find_word = [&document](std::string_view word) -> std::ptrdiff_t {
+            const auto it = std::lower_bound(document.words.begin(), document.words.end(), word);
+            return it != document.words.end() && *it == word ? it - document.words.begin() : -1;
+        };
+
+        if (std::any_of(query.minus_words.begin(), query.minus_words.end(),
+                        [&find_word](std::string_view word) { return find_word(word) >= 0; })) {
+            continue;
+        }
+
+        double relevance = 0.0;
+        bool is_matched = false;
+
+        for (const auto& [word, inverse_document_frequency] : plus_words) {
+            if (const auto index = find_word(word); index >= 0) {
+                relevance += document.term_frequencies[index] * inverse_document_frequency;
+                is_matched = true;
+            }
+        }
+
+        if (is_matched && predicate(document.id, document.status, document.rating)) {
+            selector.Push({document.id, relevance, document.rating});
+        }
+    }
+}
+
+template <typename Execution, typename Predicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(Execution policy, const std::string_view raw_query,
+                                                              Predicate predicate,
+                                                              int max_result_document_count) const {
+    if (max_result_document_count < 0) {
+        throw std::invalid_argument("negative result document count is not allowed"s);
+    }
+
+    const auto max_count = static_cast<size_t>(max_result_document_count);
+    const SearchServer::Query query = query_parser_.ParseQuery(std::execution::seq, raw_query);
+
+    // the version is not freed while the guard is alive
+    const auto guard = epochs_.Pin();
+    const IndexVersion& version = *current_version_.load();
+
+    const std::vector<ScoredWord> plus_words = ScorePlusWords(version, query);
+
+    Selector selector(max_count, &SearchServer::IsMoreRelevant);
+    FindBufferedDocuments(version, query, plus_words, predicate, selector);
+
+    const std::vector<PreparedSegment> prepared_segments = PrepareSegments(version, query, plus_words);
+
+    std::vector<Selector> segment_selectors(prepared_segments.size(), Selector(max_count, &SearchServer::IsMoreRelevant));
+    std::vector<size_t> segment_indices(prepared_segments.size());
+    std::iota(segment_indices.begin(), segment_indices.end(), 0);
+
+    std::for_each(policy, segment_indices.begin(), segment_indices.end(), [&](size_t segment_index) {
+        const auto& [segment, segment_query] = prepared_segments[segment_index];
+        const auto& removed_document_ids = segment->tombstones->document_ids;
+
+        const auto is_live_and_wanted = [&](int document_id, DocumentStatus status, int rating) {
+            return removed_document_ids.count(document_id) == 0 && predicate(document_id, status, rating);
+        };
+
+        for (Document& document : segment->index->FindTopDocuments(std::execution::seq, segment_query,
+                                                                   is_live_and_wanted, max_result_document_count)) {
+            segment_selectors[segment_index].Push(std::move(document));
+        }
+    });
+
+    for (const Selector& segment_selector : segment_selectors) {
+        selector.Merge(segment_selector);
+    }
+
+    return selector.ExtractSorted();
+}
+
+template <typename Predicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(const std::string_view raw_query, Predicate predicate,
+                                                              int max_result_document_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, predicate, max_result_document_count);
+}
+
+template <typename Execution>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(Execution policy, const std::string_view raw_query,
+                                                              const DocumentStatus& desired_status,
+                                                              int max_result_document_count) const {
+    const auto predicate = [desired_status](int, DocumentStatus document_status, int) {
+        return document_status == desired_status;
+    };
+
+    return FindTopDocuments(policy, raw_query, predicate, max_result_document_count);
+}
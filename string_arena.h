@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace search_server_storage_container {
+
+// Append-only pool for string data. Strings are copied back to back into large chunks, so storing one costs no
+// allocation of its own, and a stored string never moves until the arena is destroyed
+class StringArena {
+   public:
+    struct MemoryStatistics {
+        size_t string_count = 0;
+        size_t bytes_used = 0;      // string data
+        size_t bytes_reserved = 0;  // allocated chunks
+        size_t chunk_count = 0;
+    };
+
+   public:
+    static constexpr size_t kDefaultChunkSize = 64 * 1024;
+
+    explicit StringArena(size_t chunk_size = kDefaultChunkSize) : chunk_size_(std::max<size_t>(chunk_size, 1)) {}
+
+    // stored strings keep their addresses, the moved-from arena starts over empty
+    StringArena(StringArena&& other) noexcept
+        : chunk_size_(other.chunk_size_),
+          chunks_(std::move(other.chunks_)),
+          current_chunk_(std::exchange(other.current_chunk_, nullptr)),
+          current_chunk_left_(std::exchange(other.current_chunk_left_, 0)),
+          statistics_(std::exchange(other.statistics_, {})) {}
+
+    StringArena& operator=(StringArena&& other) noexcept {
+        if (this != &other) {
+            chunk_size_ = other.chunk_size_;
+            chunks_ = std::move(other.chunks_);
+            current_chunk_ = std::exchange(other.current_chunk_, nullptr);
+            current_chunk_left_ = std::exchange(other.current_chunk_left_, 0);
+            statistics_ = std::exchange(other.statistics_, {});
+        }
+
+        return *this;
+    }
+
+   public:
+    // Copies text into the arena, the view stays valid for the lifetime of the arena
+    std::string_view Store(std::string_view text) {
+        if (text.empty()) {
+            ++statistics_.string_count;
+            return {};
+        }
+
+        char* destination = Allocate(text.size());
+        std::memcpy(destination, text.data(), text.size());
+
+        ++statistics_.string_count;
+        statistics_.bytes_used += text.size();
+
+        return {destination, text.size()};
+    }
+
+    const MemoryStatistics& GetMemoryStatistics() const { return statistics_; }
+
+   private:
+    char* Allocate(size_t size) {
+        // a string that would waste a large part of a chunk gets a chunk of its own
+        if (size > chunk_size_ / 4) {
+            return AddChunk(size);
+        }
+
+        if (size > current_chunk_left_) {
+            current_chunk_ = AddChunk(chunk_size_);
+            current_chunk_left_ = chunk_size_;
+        }
+
+        char* result = current_chunk_;
+        current_chunk_ += size;
+        current_chunk_left_ -= size;
+
+        return result;
+    }
+
+    char* AddChunk(size_t size) {
+        chunks_.push_back(std::make_unique<char[]>(size));
+
+        ++statistics_.chunk_count;
+        statistics_.bytes_reserved += size;
+
+        return chunks_.back().get();
+    }
+
+   private:
+    size_t chunk_size_;
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    char* current_chunk_ = nullptr;
+    size_t current_chunk_left_ = 0;
+    MemoryStatistics statistics_;
+};
+
+}  // namespace search_server_storage_container
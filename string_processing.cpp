@@ -1,7 +1,13 @@
 #include "string_processing.h"
 
+#include <cstdint>
 #include <sstream>
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#define STRING_PROCESSING_X86_SIMD
+#include <immintrin.h>
+#endif
+
 namespace string_processing {
 
 std::vector<std::string> SplitIntoWords(const std::string& text) {
@@ -35,4 +41,123 @@ std::vector<std::string_view> SplitIntoWords(std::string_view text) {
     return result;
 }
 
+namespace {
+
+using Tokenizer = bool (*)(std::string_view text, std::vector<std::string_view>& words);
+
+bool IsControlCharacter(char c) { return c >= '\0' && c < ' '; }
+
+// Handles text[position, text.size()) byte by byte, word_begin is where the current word started
+bool TokenizeTail(std::string_view text, size_t position, size_t word_begin, std::vector<std::string_view>& words) {
+    for (; position < text.size(); ++position) {
+        if (text[position] == ' ') {
+            words.push_back(text.substr(word_begin, position - word_begin));
+            word_begin = position + 1;
+        } else if (IsControlCharacter(text[position])) {
+            return false;
+        }
+    }
+
+    words.push_back(text.substr(word_begin));
+
+    return true;
+}
+
+[[maybe_unused]] bool TokenizeScalar(std::string_view text, std::vector<std::string_view>& words) {
+    return TokenizeTail(text, 0, 0, words);
+}
+
+#ifdef STRING_PROCESSING_X86_SIMD
+
+// Emits a word for every set bit of space_mask, bit i standing for the space at block_begin + i
+inline void EmitWords(std::string_view text, size_t block_begin, uint32_t space_mask, size_t& word_begin,
+                      std::vector<std::string_view>& words) {
+    while (space_mask != 0) {
+        const size_t space = block_begin + static_cast<size_t>(__builtin_ctz(space_mask));
+        words.push_back(text.substr(word_begin, space - word_begin));
+        word_begin = space + 1;
+        space_mask &= space_mask - 1;
+    }
+}
+
+// 16 bytes per step, SSE2 is part of every x86-64 CPU
+bool TokenizeSse2(std::string_view text, std::vector<std::string_view>& words) {
+    constexpr size_t kBlockSize = 16;
+
+    const __m128i spaces = _mm_set1_epi8(' ');
+    const __m128i minus_one = _mm_set1_epi8(-1);
+
+    size_t word_begin = 0;
+    size_t position = 0;
+
+    for (; position + kBlockSize <= text.size(); position += kBlockSize) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + position));
+
+        // control characters are the bytes in [0, ' ') compared as signed
+        const __m128i is_control = _mm_and_si128(_mm_cmpgt_epi8(block, minus_one), _mm_cmplt_epi8(block, spaces));
+
+        if (_mm_movemask_epi8(is_control) != 0) {
+            return false;
+        }
+
+        const auto space_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, spaces)));
+        EmitWords(text, position, space_mask, word_begin, words);
+    }
+
+    return TokenizeTail(text, position, word_begin, words);
+}
+
+// 32 bytes per step
+__attribute__((target("avx2"))) bool TokenizeAvx2(std::string_view text, std::vector<std::string_view>& words) {
+    constexpr size_t kBlockSize = 32;
+
+    const __m256i spaces = _mm256_set1_epi8(' ');
+    const __m256i minus_one = _mm256_set1_epi8(-1);
+
+    size_t word_begin = 0;
+    size_t position = 0;
+
+    for (; position + kBlockSize <= text.size(); position += kBlockSize) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + position));
+
+        const __m256i is_control =
+            _mm256_and_si256(_mm256_cmpgt_epi8(block, minus_one), _mm256_cmpgt_epi8(spaces, block));
+
+        if (_mm256_movemask_epi8(is_control) != 0) {
+            return false;
+        }
+
+        const auto space_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, spaces)));
+        EmitWords(text, position, space_mask, word_begin, words);
+    }
+
+    return TokenizeTail(text, position, word_begin, words);
+}
+
+#endif
+
+Tokenizer SelectTokenizer() {
+#ifdef STRING_PROCESSING_X86_SIMD
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return TokenizeAvx2;
+    }
+
+    return TokenizeSse2;
+#else
+    return TokenizeScalar;
+#endif
+}
+
+}  // namespace
+
+bool SplitIntoWordsValidated(std::string_view text, std::vector<std::string_view>& words) {
+    static const Tokenizer tokenizer = SelectTokenizer();
+
+    words.clear();
+
+    return tokenizer(text, words);
+}
+
 }  // namespace string_processing
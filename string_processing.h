@@ -9,4 +9,10 @@ std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
 std::vector<std::string> SplitIntoWords(const std::string& text);
 
+// Splits text by every single space, like SplitIntoWords(std::string_view), and checks it for control characters
+// (codes 0-31) in the same pass. Words are written to the cleared `words`, so the buffer can be reused between calls.
+// SSE2/AVX2 is chosen at runtime where available. Returns false if a control character is found, words are then
+// incomplete
+bool SplitIntoWordsValidated(std::string_view text, std::vector<std::string_view>& words);
+
 }  // namespace string_processing
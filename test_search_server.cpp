@@ -1,13 +1,67 @@
 #include "test_search_server.h"
 
+#include <algorithm>
 #include <cassert>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <thread>
 #include <vector>
 
+#include "compressed_search_server.h"
+#include "concurrent_request_queue.h"
+#include "document_bitmap.h"
+#include "integer_codec.h"
+#include "mapped_search_server.h"
+#include "posting_list.h"
+#include "process_queries.h"
 #include "remove_duplicates.h"
+#include "score_accumulator.h"
 #include "search_server.h"
+#include "search_server_snapshot.h"
+#include "segmented_search_server.h"
+#include "string_arena.h"
 #include "string_processing.h"
 #include "testing_framework.h"
+#include "word_storage.h"
+
+namespace {
+
+constexpr double kAccuracy = 1e-6;
+
+const std::vector<std::string> kDocumentTextWords = {"white"s, "cat"s, "yellow"s, "hat"s, "curly"s, "tail"s,
+                                                     "nasty"s, "dog"s, "big"s,    "eyes"s, "john"s};
+
+// Four of kDocumentTextWords, so the documents share words with each other
+std::string MakeDocumentText(int document_id) {
+    std::string text;
+    for (int word = 0; word < 4; ++word) {
+        text += (text.empty() ? ""s : " "s) +
+                kDocumentTextWords[(document_id * 7 + word * word * 3) % kDocumentTextWords.size()];
+    }
+    return text;
+}
+
+// Same documents in the same order, relevance within kAccuracy
+void AssertSameDocuments(const std::vector<Document>& found, const std::vector<Document>& expected) {
+    ASSERT_EQUAL(found.size(), expected.size());
+
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQUAL(found[i].id, expected[i].id);
+        ASSERT_EQUAL(found[i].rating, expected[i].rating);
+        ASSERT(std::abs(found[i].relevance - expected[i].relevance) < kAccuracy);
+    }
+}
+
+}  // namespace
 
 void TestIteratingOverSearchServer() {
     SearchServer search_server;
@@ -48,6 +102,93 @@ void TestGetWordFrequencies() {
     }
 }
 
+void TestWordStorageHandsOutDenseIds() {
+    search_server_storage_container::WordStorage words_storage;
+
+    ASSERT_EQUAL(words_storage.Insert("cat"sv), 0u);
+    ASSERT_EQUAL(words_storage.Insert("dog"s), 1u);
+    ASSERT_EQUAL(words_storage.Insert(std::string("cat"s)), 0u);
+    ASSERT_EQUAL(words_storage.Size(), 2u);
+
+    ASSERT(words_storage.Find("dog"sv) == 1u);
+    ASSERT(!words_storage.Find("bird"sv));
+    ASSERT_EQUAL(words_storage.GetWord(1), "dog"sv);
+}
+
+void TestStringArenaKeepsStringsInPlace() {
+    search_server_storage_container::StringArena arena(64);
+
+    std::vector<std::string_view> stored;
+    std::vector<std::string> originals;
+
+    for (int i = 0; i < 100; ++i) {
+        originals.push_back(std::string(i % 30, 'a' + i % 26) + std::to_string(i));
+        stored.push_back(arena.Store(originals.back()));
+    }
+
+    // moving the arena keeps the data where it is
+    auto moved_arena = std::move(arena);
+    moved_arena.Store(std::string(500, 'z'));
+
+    for (size_t i = 0; i < originals.size(); ++i) {
+        ASSERT_EQUAL(stored[i], std::string_view(originals[i]));
+    }
+
+    const auto& statistics = moved_arena.GetMemoryStatistics();
+
+    ASSERT_EQUAL(statistics.string_count, 101u);
+    ASSERT(statistics.bytes_used <= statistics.bytes_reserved);
+    ASSERT(statistics.chunk_count < 101u);
+}
+
+void TestGetTermFrequencies() {
+    SearchServer search_server;
+
+    search_server.AddDocument(0, "funny funny cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+
+    const auto& term_frequencies = search_server.GetTermFrequencies(1);
+
+    ASSERT_EQUAL(term_frequencies.size(), 2u);
+    ASSERT(term_frequencies[0].term_id < term_frequencies[1].term_id);
+    ASSERT_EQUAL(search_server.GetWord(term_frequencies[0].term_id), "cat"sv);
+    ASSERT_EQUAL(search_server.GetWord(term_frequencies[1].term_id), "dog"sv);
+    ASSERT_EQUAL(term_frequencies[1].frequency, 0.5);
+
+    ASSERT(search_server.GetTermFrequencies(42).empty());
+}
+
+void TestInverseDocumentFrequenciesFollowDocumentCount() {
+    SearchServer search_server;
+
+    search_server.AddDocument(0, "cat dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1});
+
+    ASSERT(search_server.GetInverseDocumentFrequency("cat"sv) == 0.0);
+    ASSERT(search_server.GetInverseDocumentFrequency("dog"sv) == std::log(2.0));
+    ASSERT(!search_server.GetInverseDocumentFrequency("bird"sv));
+
+    search_server.AddDocuments(
+        {{2, "bird"sv, DocumentStatus::ACTUAL, {1}}, {3, "bird dog"sv, DocumentStatus::ACTUAL, {1}}});
+
+    ASSERT(search_server.GetInverseDocumentFrequency("cat"sv) == std::log(2.0));
+    ASSERT(search_server.GetInverseDocumentFrequency("bird"sv) == std::log(2.0));
+
+    search_server.RemoveDocument(0);
+
+    ASSERT(search_server.GetInverseDocumentFrequency("cat"sv) == std::log(3.0));
+    ASSERT(search_server.GetInverseDocumentFrequency("dog"sv) == std::log(3.0));
+
+    // scoring uses the cached values
+    const auto found = search_server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(found.size(), 1u);
+    ASSERT(std::abs(found[0].relevance - std::log(3.0)) < 1e-6);
+
+    search_server.RemoveDocument(1);
+
+    ASSERT(!search_server.GetInverseDocumentFrequency("cat"sv));
+}
+
 void TestDeletingDocument() {
     SearchServer search_server;
 
@@ -78,6 +219,186 @@ void TestRemoveDuplicates() {
     assert(search_server.GetDocumentCount() == 3);
 }
 
+void TestRemoveDuplicatesReturnsRemovedIds() {
+    SearchServer search_server("and with"s);
+
+    search_server_helpers::AddDocument(search_server, 1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7});
+    search_server_helpers::AddDocument(search_server, 2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1});
+    // same words in another order and count, and with stop words
+    search_server_helpers::AddDocument(search_server, 3, "rat nasty pet funny funny"s, DocumentStatus::ACTUAL, {1});
+    search_server_helpers::AddDocument(search_server, 4, "curly hair funny pet with and"s, DocumentStatus::BANNED,
+                                       {9});
+    search_server_helpers::AddDocument(search_server, 5, "nasty rat"s, DocumentStatus::ACTUAL, {1});
+    search_server_helpers::AddDocument(search_server, 6, "and with"s, DocumentStatus::ACTUAL, {1});
+    search_server_helpers::AddDocument(search_server, 7, "with"s, DocumentStatus::ACTUAL, {1});
+
+    const std::vector<int> expected_ids = {3, 4, 7};
+
+    ASSERT(remove_duplicates::FindDuplicates(std::execution::par, search_server) == expected_ids);
+    ASSERT(remove_duplicates::RemoveDuplicates(search_server) == expected_ids);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 4);
+    ASSERT(remove_duplicates::RemoveDuplicates(std::execution::par, search_server).empty());
+
+    // documents with colliding fingerprints are told apart by their words
+    const std::vector<int> document_ids(search_server.begin(), search_server.end());
+    const std::vector<remove_duplicates::Fingerprint> fingerprints(document_ids.size());
+
+    ASSERT(remove_duplicates::CollectDuplicates(search_server, document_ids, fingerprints).empty());
+}
+
+void TestFindNearDuplicatesClustersSimilarDocuments() {
+    const std::string page = "breaking news about the city council meeting held on monday evening in the old town hall"s;
+
+    SearchServer search_server;
+
+    search_server_helpers::AddDocument(search_server, 1, page, DocumentStatus::ACTUAL, {1});
+    search_server_helpers::AddDocument(search_server, 2, "curly cat with a fluffy tail"s, DocumentStatus::ACTUAL, {1});
+    // a word added to fifteen, similarity 15 / 16
+    search_server_helpers::AddDocument(search_server, 3, page + " tuesday"s, DocumentStatus::ACTUAL, {1});
+    search_server_helpers::AddDocument(search_server, 4, "curly cat with a fluffy tail"s, DocumentStatus::ACTUAL, {1});
+    search_server_helpers::AddDocument(search_server, 5, "nasty dog with big eyes"s, DocumentStatus::ACTUAL, {1});
+    search_server_helpers::AddDocument(search_server, 6, "the old town hall"s, DocumentStatus::ACTUAL, {1});
+
+    const std::vector<std::vector<int>> expected_clusters = {{1, 3}, {2, 4}};
+
+    ASSERT(remove_duplicates::FindNearDuplicates(search_server) == expected_clusters);
+    ASSERT(remove_duplicates::FindNearDuplicates(std::execution::par, search_server) == expected_clusters);
+
+    // at similarity 1 only documents with the same words are clustered
+    const std::vector<std::vector<int>> exact_clusters = {{2, 4}};
+    ASSERT(remove_duplicates::FindNearDuplicates(search_server, 1.0) == exact_clusters);
+
+    try {
+        remove_duplicates::FindNearDuplicates(search_server, 0.0);
+        ASSERT_HINT(false, "similarity threshold of 0 must be rejected"s);
+    } catch (const std::invalid_argument&) {
+    }
+
+    ASSERT_EQUAL(remove_duplicates::GetBandRowCount(1.0), remove_duplicates::kSignatureSize);
+    ASSERT(remove_duplicates::GetBandRowCount(0.5) < remove_duplicates::GetBandRowCount(0.9));
+}
+
+void TestProcessQueriesFlattenedMatchesProcessQueries() {
+    SearchServer search_server("and with"s);
+
+    search_server_helpers::AddDocument(search_server, 1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7});
+    search_server_helpers::AddDocument(search_server, 2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1});
+    search_server_helpers::AddDocument(search_server, 3, "nasty dog with big eyes"s, DocumentStatus::ACTUAL, {2});
+    search_server_helpers::AddDocument(search_server, 4, "big cat nasty hair"s, DocumentStatus::ACTUAL, {3});
+
+    // queries without results come first, in between and last
+    const std::vector<std::string> queries = {"parrot"s, "nasty rat -not"s, "not very funny nasty pet"s, "parrot"s,
+                                              "curly hair"s, "parrot"s};
+
+    const auto results = ProcessQueries(search_server, queries);
+    const QueryResults flattened_results = ProcessQueriesFlattened(search_server, queries);
+
+    ASSERT_EQUAL(flattened_results.GetQueryCount(), queries.size());
+
+    std::vector<int> expected_ids;
+    for (size_t query = 0; query < queries.size(); ++query) {
+        const auto documents = flattened_results.GetDocuments(query);
+        ASSERT_EQUAL(documents.size(), results[query].size());
+
+        for (size_t position = 0; position < results[query].size(); ++position) {
+            ASSERT_EQUAL(documents.begin()[position].id, results[query][position].id);
+            expected_ids.push_back(results[query][position].id);
+        }
+    }
+
+    std::vector<int> flattened_ids;
+    for (const Document& document : flattened_results) {
+        flattened_ids.push_back(document.id);
+    }
+
+    std::vector<int> joined_ids;
+    for (const Document& document : ProcessQueriesJoined(search_server, queries)) {
+        joined_ids.push_back(document.id);
+    }
+
+    std::vector<int> viewed_ids;
+    for (const Document& document : JoinedDocumentsView(results)) {
+        viewed_ids.push_back(document.id);
+    }
+
+    ASSERT(!expected_ids.empty());
+    ASSERT(flattened_ids == expected_ids);
+    ASSERT(joined_ids == expected_ids);
+    ASSERT(viewed_ids == expected_ids);
+
+    const std::vector<std::vector<Document>> no_results(3);
+    ASSERT(JoinedDocumentsView(no_results).empty());
+    ASSERT_EQUAL(ProcessQueriesFlattened(search_server, {}).GetQueryCount(), 0u);
+}
+
+void TestConcurrentRequestQueueExpiresByTime() {
+    SearchServer search_server("and in at"s);
+    search_server_helpers::AddDocument(search_server, 1, "curly cat curly tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server_helpers::AddDocument(search_server, 2, "curly dog and fancy collar"s, DocumentStatus::ACTUAL, {1});
+
+    ConcurrentRequestQueue::TimePoint now;
+    ConcurrentRequestQueue request_queue(search_server, [&now] { return now; });
+
+    for (int i = 0; i < 3; ++i) {
+        request_queue.AddFindRequest("empty request"s);
+    }
+    ASSERT_EQUAL(request_queue.AddFindRequest("curly dog"s).size(), 2u);
+
+    now += std::chrono::minutes(1);
+    request_queue.AddFindRequest("sparrow"s);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 4);
+
+    const auto last_minute = request_queue.GetWindowStatistics(std::chrono::minutes(1));
+    ASSERT_EQUAL(last_minute.request_count, 1u);
+    ASSERT_EQUAL(last_minute.no_result_request_count, 1u);
+    ASSERT_EQUAL(request_queue.GetWindowStatistics(std::chrono::minutes(2)).request_count, 5u);
+
+    // the first minute is still in the day, then leaves it however few requests came since
+    now += std::chrono::minutes(ConcurrentRequestQueue::kMinutesInADay - 2);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 4);
+    now += std::chrono::minutes(1);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1);
+
+    // a request in a bucket of an expired minute restarts its count
+    request_queue.AddFindRequest("curly"s, [](int document_id, DocumentStatus, int) { return document_id > 2; });
+    ASSERT_EQUAL(request_queue.GetWindowStatistics(std::chrono::minutes(1)).no_result_request_count, 1u);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 2);
+
+    try {
+        request_queue.GetWindowStatistics(std::chrono::minutes(ConcurrentRequestQueue::kMinutesInADay + 1));
+        ASSERT_HINT(false, "statistics window longer than a day is accepted"s);
+    } catch (const std::invalid_argument&) {
+    }
+}
+
+void TestConcurrentRequestQueueCountsConcurrentRequests() {
+    constexpr int kThreadCount = 4;
+    constexpr int kRequestsPerThread = 500;
+
+    SearchServer search_server;
+    search_server_helpers::AddDocument(search_server, 1, "curly cat"s, DocumentStatus::ACTUAL, {1});
+
+    ConcurrentRequestQueue request_queue(search_server);
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kThreadCount; ++thread) {
+        threads.emplace_back([&request_queue] {
+            for (int i = 0; i < kRequestsPerThread; ++i) {
+                request_queue.AddFindRequest(i % 2 == 0 ? "cat"s : "dog"s);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    const auto statistics =
+        request_queue.GetWindowStatistics(std::chrono::minutes(ConcurrentRequestQueue::kMinutesInADay));
+    ASSERT_EQUAL(statistics.request_count, static_cast<uint64_t>(kThreadCount * kRequestsPerThread));
+    ASSERT_EQUAL(statistics.no_result_request_count, static_cast<uint64_t>(kThreadCount * kRequestsPerThread / 2));
+}
+
 void TestStopWordsExclusion() {
     const std::vector<int> ratings = {1, 2, 3};
 
@@ -164,7 +485,7 @@ void TestMatchDocumentResults() {
 
         const auto [words, status] = server.MatchDocument("fat cat out of city"sv, 42);
 
-        std::vector<std::string_view> desired_matched_words{"cat"s, "city"s};
+        std::vector<std::string_view> desired_matched_words{"cat"sv, "city"sv};
 
         ASSERT_EQUAL(words, desired_matched_words);
         ASSERT_EQUAL(status, DocumentStatus::ACTUAL);
@@ -179,7 +500,7 @@ void TestMatchDocumentResults() {
 
         const auto [words, status] = server.MatchDocument("fat cat out of city and a cute dog"s, 43);
 
-        std::vector<std::string_view> desired_matched_words{"dog"s};
+        std::vector<std::string_view> desired_matched_words{"dog"sv};
 
         ASSERT_EQUAL(words, desired_matched_words);
         ASSERT_EQUAL(status, DocumentStatus::BANNED);
@@ -187,8 +508,6 @@ void TestMatchDocumentResults() {
 }
 
 void TestFindTopDocumentsResultsSorting() {
-    constexpr double kAccuracy = 1e-6;
-
     const std::vector<int> ratings = {1, 2, 3};
 
     {
@@ -331,8 +650,6 @@ void TestFilteringByStatus() {
 }
 
 void TestRelevanceCalculation() {
-    constexpr double kAccuracy = 1e-6;
-
     SearchServer server;
 
     server.AddDocument(0, "cat cat city dog"sv, DocumentStatus::ACTUAL, {1});
@@ -371,6 +688,30 @@ void TestSplitIntoWordsEscapesSpaces() {
     ASSERT_EQUAL(std::vector<std::string>{}, string_processing::SplitIntoWords("                 "s));
 }
 
+void TestSplitIntoWordsValidatedMatchesSplitIntoWords() {
+    std::vector<std::string_view> words;
+
+    std::vector<std::string> texts = {""s, " "s, "cat"s, "  cat  dog "s, "пушистый кот"s};
+    std::string long_text;
+    for (int i = 0; i < 40; ++i) {
+        long_text += std::string(i % 5, ' ') + "word"s + std::to_string(i);
+        texts.push_back(long_text);
+    }
+
+    for (const std::string& text : texts) {
+        ASSERT(string_processing::SplitIntoWordsValidated(text, words));
+        ASSERT_EQUAL(words, string_processing::SplitIntoWords(std::string_view(text)));
+    }
+
+    // a control character anywhere, in a vector block or in the tail, is found
+    for (size_t position = 0; position < 100; ++position) {
+        std::string text = long_text.substr(0, 100);
+        text[position] = position % 2 == 0 ? '\x12' : '\t';
+
+        ASSERT_HINT(!string_processing::SplitIntoWordsValidated(text, words), std::to_string(position));
+    }
+}
+
 void TestAddDocumentWithRepeatingId() {
     SearchServer search_server;
 
@@ -445,12 +786,1168 @@ void TestEmptyMinusWord() {
     ASSERT_HINT(false, "query with empty minus word is not handled"s);
 }
 
+void TestMatchDocumentWithInvalidQuery() {
+    SearchServer search_server;
+
+    search_server.AddDocument(1, "funny cat"s, DocumentStatus::ACTUAL, {1});
+
+    try {
+        search_server.MatchDocument("funny --cat"s, 1);
+    } catch (std::invalid_argument& e) {
+        // the error must not leak into the next query
+        ASSERT_EQUAL(search_server.FindTopDocuments("cat"s).size(), 1u);
+        return;
+    }
+
+    ASSERT_HINT(false, "match with double minus word is not handled"s);
+}
+
+void TestConcurrentQueriesReportOwnErrors() {
+    SearchServer search_server;
+
+    for (int document_id = 0; document_id < 100; ++document_id) {
+        search_server.AddDocument(document_id, "funny cat number"s + std::to_string(document_id % 10),
+                                  DocumentStatus::ACTUAL, {1});
+    }
+
+    std::atomic<int> wrong_outcomes = 0;
+    std::vector<std::thread> threads;
+
+    for (int thread_index = 0; thread_index < 8; ++thread_index) {
+        threads.emplace_back([&search_server, &wrong_outcomes, thread_index]() {
+            for (int i = 0; i < 200; ++i) {
+                const bool is_valid = (i + thread_index) % 2 == 0;
+
+                try {
+                    if (is_valid) {
+                        search_server.FindTopDocuments(std::execution::par, "funny -number3"s, DocumentStatus::ACTUAL);
+                        search_server.MatchDocument(std::execution::par, "cat number4"s, i % 100);
+                    } else {
+                        search_server.FindTopDocuments(std::execution::par, "funny --cat"s, DocumentStatus::ACTUAL);
+                    }
+
+                    wrong_outcomes += is_valid ? 0 : 1;
+                } catch (const std::invalid_argument&) {
+                    wrong_outcomes += is_valid ? 1 : 0;
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQUAL(wrong_outcomes.load(), 0);
+}
+
 void TestSearchNonExistentWord() {
     SearchServer search_server;
 
     search_server.FindTopDocuments("potato");
 }
 
+void TestPostingListKeepsDocumentsSorted() {
+    search_server_storage_container::PostingList posting_list;
+
+    posting_list.Add(5, 0.5);
+    posting_list.Add(1, 0.25);
+    posting_list.Add(3, 0.125);
+    posting_list.Add(1, 0.25);
+
+    ASSERT_EQUAL(posting_list.GetDocumentIds(), (std::vector<int>{1, 3, 5}));
+    ASSERT_EQUAL(posting_list.GetTermFrequencies(), (std::vector<double>{0.5, 0.125, 0.5}));
+    ASSERT(posting_list.Contains(3));
+
+    ASSERT(posting_list.Remove(3));
+    ASSERT(!posting_list.Remove(3));
+    ASSERT(!posting_list.Contains(3));
+    ASSERT_EQUAL(posting_list.GetDocumentIds(), (std::vector<int>{1, 5}));
+}
+
+void TestPostingListKeepsBlockBounds() {
+    using search_server_storage_container::PostingList;
+
+    // blocks recomputed from scratch, to check the maintained ones against
+    const auto expect_exact_blocks = [](const PostingList& posting_list) {
+        const auto& document_ids = posting_list.GetDocumentIds();
+        const auto& term_frequencies = posting_list.GetTermFrequencies();
+        const size_t block_count = (document_ids.size() + PostingList::kBlockSize - 1) / PostingList::kBlockSize;
+
+        ASSERT_EQUAL(posting_list.GetBlockLastDocumentIds().size(), block_count);
+        ASSERT_EQUAL(posting_list.GetBlockMaxTermFrequencies().size(), block_count);
+
+        for (size_t block = 0; block < block_count; ++block) {
+            const size_t first = block * PostingList::kBlockSize;
+            const size_t last = std::min(first + PostingList::kBlockSize, document_ids.size());
+
+            ASSERT_EQUAL(posting_list.GetBlockLastDocumentIds()[block], document_ids[last - 1]);
+            ASSERT_EQUAL(posting_list.GetBlockMaxTermFrequencies()[block],
+                         *std::max_element(term_frequencies.begin() + first, term_frequencies.begin() + last));
+        }
+    };
+
+    PostingList posting_list;
+
+    for (int document_id = 0; document_id < 300; document_id += 2) {
+        posting_list.Add(document_id, 1.0 / (1 + document_id % 37));
+    }
+    expect_exact_blocks(posting_list);
+
+    // out of order ids shift the block boundaries
+    posting_list.Add(1, 0.75);
+    posting_list.Add(151, 2.0);
+    posting_list.Add(0, 5.0);
+    expect_exact_blocks(posting_list);
+    ASSERT_EQUAL(posting_list.GetMaxTermFrequency(), 6.0);
+
+    const std::vector<int> merged_document_ids = {3, 5, 401, 403};
+    const std::vector<double> merged_term_frequencies = {0.5, 0.5, 0.5, 7.0};
+    posting_list.Merge(merged_document_ids.data(), merged_term_frequencies.data(), merged_document_ids.size());
+    expect_exact_blocks(posting_list);
+
+    // removing the largest frequencies lowers the bounds
+    ASSERT(posting_list.Remove(403));
+    ASSERT(posting_list.Remove(0));
+    expect_exact_blocks(posting_list);
+    ASSERT_EQUAL(posting_list.GetMaxTermFrequency(), 2.0);
+
+    while (!posting_list.IsEmpty()) {
+        posting_list.Remove(posting_list.GetDocumentIds()[posting_list.Size() / 2]);
+    }
+    expect_exact_blocks(posting_list);
+    ASSERT_EQUAL(posting_list.GetMaxTermFrequency(), 0.0);
+}
+
+void TestRemovedDocumentIsNotMatched() {
+    SearchServer search_server;
+
+    search_server.AddDocument(2, "white cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(1, "black cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(3, "white dog"s, DocumentStatus::ACTUAL, {1});
+
+    search_server.RemoveDocument(std::execution::par, 2);
+
+    const auto found_docs = search_server.FindTopDocuments("white cat"s);
+
+    ASSERT_EQUAL(found_docs.size(), 2u);
+
+    const auto [words, status] = search_server.MatchDocument("white cat"s, 1);
+
+    ASSERT_EQUAL(words, std::vector<std::string_view>{"cat"sv});
+}
+
+void TestRemovedDocumentsAreCompactedLazily() {
+    const auto is_removed = [](int document_id) { return document_id % 5 == 1; };
+
+    // the removed documents were never added here
+    SearchServer expected_server;
+    for (int document_id = 0; document_id < 200; ++document_id) {
+        if (!is_removed(document_id)) {
+            expected_server.AddDocument(document_id, MakeDocumentText(document_id), DocumentStatus::ACTUAL,
+                                        {document_id});
+        }
+    }
+
+    const auto check_matches_expected = [&](SearchServer& server) {
+        ASSERT_EQUAL(server.GetDocumentCount(), expected_server.GetDocumentCount());
+
+        for (const auto& word : kDocumentTextWords) {
+            ASSERT(server.GetInverseDocumentFrequency(word) == expected_server.GetInverseDocumentFrequency(word));
+        }
+
+        for (const auto retrieval_mode :
+             {SearchServer::RetrievalMode::EXHAUSTIVE, SearchServer::RetrievalMode::MAX_SCORE}) {
+            server.SetRetrievalMode(retrieval_mode);
+
+            for (const auto& query : {"cat dog"s, "curly -tail"s, "white hat big"s, "eyes john -nasty"s}) {
+                const auto expected = expected_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 20);
+                const auto found = server.FindTopDocuments(query, DocumentStatus::ACTUAL, 20);
+
+                AssertSameDocuments(found, expected);
+            }
+        }
+    };
+
+    // purged on every removal, never purged on its own, and the default in between
+    for (const double compaction_threshold : {0.0, 1.0, SearchServer::kDefaultCompactionThreshold}) {
+        SearchServer server;
+        server.SetCompactionThreshold(compaction_threshold);
+
+        for (int document_id = 0; document_id < 200; ++document_id) {
+            server.AddDocument(document_id, MakeDocumentText(document_id), DocumentStatus::ACTUAL, {document_id});
+        }
+
+        for (int document_id = 0; document_id < 200; ++document_id) {
+            if (is_removed(document_id)) {
+                server.RemoveDocument(document_id);
+            }
+        }
+
+        check_matches_expected(server);
+
+        // an id whose postings are still in the index can be taken by a new document
+        server.AddDocument(1, "purple whale"s, DocumentStatus::ACTUAL, {1});
+        ASSERT_EQUAL(server.FindTopDocuments("cat dog white yellow hat curly tail nasty big eyes john whale"s,
+                                             DocumentStatus::ACTUAL, 500)
+                         .size(),
+                     static_cast<size_t>(server.GetDocumentCount()));
+        ASSERT_EQUAL(std::get<0>(server.MatchDocument(MakeDocumentText(1) + " whale"s, 1)),
+                     std::vector<std::string_view>{"whale"sv});
+        server.RemoveDocument(1);
+
+        server.Compact();
+        check_matches_expected(server);
+    }
+
+    try {
+        SearchServer server;
+        server.SetCompactionThreshold(1.5);
+        ASSERT_HINT(false, "compaction threshold above 1 is accepted"s);
+    } catch (const std::invalid_argument&) {
+    }
+}
+
+void TestMaxResultDocumentCount() {
+    SearchServer search_server;
+
+    for (int document_id = 0; document_id < 20; ++document_id) {
+        search_server.AddDocument(document_id, "cat"s + std::string(document_id % 7, 'a') + " cat city"s,
+                                  DocumentStatus::ACTUAL, {document_id});
+    }
+
+    ASSERT_EQUAL(search_server.FindTopDocuments("cat"s).size(),
+                 static_cast<size_t>(SearchServer::kDefaultMaxResultDocumentCount));
+    ASSERT_EQUAL(search_server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 12).size(), 12u);
+    ASSERT(search_server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 0).empty());
+
+    const auto sequential = search_server.FindTopDocuments(std::execution::seq, "city catc"s, DocumentStatus::ACTUAL, 8);
+    const auto parallel = search_server.FindTopDocuments(std::execution::par, "city catc"s, DocumentStatus::ACTUAL, 8);
+
+    ASSERT_EQUAL(sequential.size(), 8u);
+    ASSERT_EQUAL(parallel.size(), 8u);
+
+    for (size_t i = 0; i < sequential.size(); ++i) {
+        ASSERT_EQUAL(sequential[i].id, parallel[i].id);
+    }
+
+    // the count bounds the results and is not allocated up front
+    constexpr int kHugeCount = std::numeric_limits<int>::max();
+
+    for (const auto mode : {SearchServer::RetrievalMode::MAX_SCORE, SearchServer::RetrievalMode::EXHAUSTIVE}) {
+        search_server.SetRetrievalMode(mode);
+
+        ASSERT_EQUAL(search_server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, kHugeCount).size(), 20u);
+        ASSERT_EQUAL(
+            search_server.FindTopDocuments(std::execution::par, "cat"s, DocumentStatus::ACTUAL, kHugeCount).size(),
+            20u);
+    }
+
+    SegmentedSearchServer segmented(""s, 8);
+    for (int document_id = 0; document_id < 20; ++document_id) {
+        segmented.AddDocument(document_id, "cat city"s, DocumentStatus::ACTUAL, {document_id});
+    }
+
+    ASSERT_EQUAL(segmented.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, kHugeCount).size(), 20u);
+    ASSERT_EQUAL(segmented.FindTopDocuments(std::execution::par, "cat"s, DocumentStatus::ACTUAL, kHugeCount).size(),
+                 20u);
+
+    const CompressedSearchServer compressed(search_server);
+    ASSERT_EQUAL(compressed.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, kHugeCount).size(), 20u);
+}
+
+void TestShardedParallelScoringMatchesSequential() {
+    SearchServer search_server("and"s);
+
+    const std::vector<std::string> words = {"cat"s, "dog"s, "city"s, "tail"s, "eyes"s, "hat"s, "and"s};
+
+    for (int document_id = 0; document_id < 20'000; document_id += 2) {
+        std::string document;
+        for (size_t i = 0; i < 4; ++i) {
+            document += words[(document_id / 2 + i * i + document_id % 7) % words.size()] + " "s;
+        }
+        document += "id"s + std::to_string(document_id % 101);
+
+        // unique ratings order documents of equal relevance, so the shards have to agree on ids too
+        search_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, {document_id});
+    }
+
+    for (const int shard_count : {1, 3, 8}) {
+        search_server.SetParallelScoringShardCount(shard_count);
+
+        for (const auto& query : {"cat city -dog"s, "tail id17 hat"s, "eyes -id5"s}) {
+            const auto sequential = search_server.FindTopDocuments(std::execution::seq, query, DocumentStatus::ACTUAL, 10);
+            const auto parallel = search_server.FindTopDocuments(std::execution::par, query, DocumentStatus::ACTUAL, 10);
+
+            AssertSameDocuments(parallel, sequential);
+        }
+    }
+}
+
+void TestResultCacheServesRepeatedQueries() {
+    const auto make_server = [] {
+        SearchServer search_server("in the"s);
+        search_server_helpers::AddDocument(search_server, 1, "white cat in the city"s, DocumentStatus::ACTUAL, {8});
+        search_server_helpers::AddDocument(search_server, 2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, {7});
+        search_server_helpers::AddDocument(search_server, 3, "groomed dog in the city"s, DocumentStatus::BANNED, {5});
+        return search_server;
+    };
+
+    const auto ids = [](const std::vector<Document>& documents) {
+        std::vector<int> document_ids;
+        for (const Document& document : documents) {
+            document_ids.push_back(document.id);
+        }
+        return document_ids;
+    };
+
+    {
+        SearchServer search_server = make_server();
+        search_server.FindTopDocuments("cat city"s);
+        search_server.FindTopDocuments("cat city"s);
+        ASSERT_EQUAL(search_server.GetResultCacheStatistics().hit_count, 0u);
+        ASSERT_EQUAL(search_server.GetResultCacheStatistics().miss_count, 0u);
+    }
+
+    SearchServer search_server = make_server();
+    const SearchServer reference_server = make_server();
+    search_server.SetResultCacheCapacity(8);
+
+    ASSERT(ids(search_server.FindTopDocuments("cat city -tail"s)) ==
+           ids(reference_server.FindTopDocuments("cat city -tail"s)));
+    ASSERT_EQUAL(search_server.GetResultCacheStatistics().miss_count, 1u);
+
+    // the same words in another order, repeated and with stop words make the same key
+    ASSERT(ids(search_server.FindTopDocuments("city -tail in the cat cat"s)) ==
+           ids(reference_server.FindTopDocuments("cat city -tail"s)));
+    ASSERT(ids(search_server.FindTopDocuments(std::execution::par, "cat city -tail"s, DocumentStatus::ACTUAL)) ==
+           ids(reference_server.FindTopDocuments("cat city -tail"s)));
+    ASSERT_EQUAL(search_server.GetResultCacheStatistics().hit_count, 2u);
+
+    // status and result count are parts of the key
+    ASSERT(ids(search_server.FindTopDocuments("cat city -tail"s, DocumentStatus::BANNED)) == std::vector<int>{3});
+    ASSERT_EQUAL(search_server.FindTopDocuments("cat city -tail"s, DocumentStatus::ACTUAL, 0).size(), 0u);
+    ASSERT_EQUAL(search_server.GetResultCacheStatistics().miss_count, 3u);
+
+    // adding and removing documents make cached results stale
+    search_server.AddDocument(4, "cat city cat city"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL(search_server.FindTopDocuments("cat city -tail"s).front().id, 4);
+
+    search_server.RemoveDocument(4);
+    ASSERT(ids(search_server.FindTopDocuments("cat city -tail"s)) ==
+           ids(reference_server.FindTopDocuments("cat city -tail"s)));
+    ASSERT_EQUAL(search_server.GetResultCacheStatistics().hit_count, 2u);
+    ASSERT_EQUAL(search_server.GetResultCacheStatistics().miss_count, 5u);
+
+    // the least recently used query makes room
+    search_server.SetResultCacheCapacity(1);
+    search_server.FindTopDocuments("cat"s);
+    search_server.FindTopDocuments("dog"s);
+    search_server.FindTopDocuments("dog"s);
+    search_server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(search_server.GetResultCacheStatistics().hit_count, 3u);
+    ASSERT_EQUAL(search_server.GetResultCacheStatistics().miss_count, 8u);
+}
+
+void TestMaxScoreRetrievalMatchesExhaustive() {
+    SearchServer search_server("and"s);
+
+    // word i is about twice as common as word i + 1, so queries mix frequent and rare words
+    const std::vector<std::string> words = {"cat"s,  "dog"s,   "city"s,  "tail"s,   "eyes"s,  "hat"s,
+                                            "john"s, "curly"s, "white"s, "pigeon"s, "nasty"s, "big"s};
+
+    for (int document_id = 0; document_id < 5'000; ++document_id) {
+        std::string document;
+        unsigned int bits = static_cast<unsigned int>(document_id) * 2654435761u;
+
+        for (int i = 0; i < 6; ++i, bits = bits * 1103515245u + 12345u) {
+            size_t word = 0;
+            while (word + 1 < words.size() && (bits >> (8 + word)) % 2 == 1) {
+                ++word;
+            }
+            document += words[word] + " "s;
+        }
+
+        const auto status = document_id % 9 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        search_server.AddDocument(document_id, document, status, {document_id % 17});
+    }
+
+    // removed postings leave the score bounds loose, which must not change the results
+    for (int document_id = 0; document_id < 5'000; document_id += 11) {
+        search_server.RemoveDocument(document_id);
+    }
+
+    const auto find = [&search_server](SearchServer::RetrievalMode retrieval_mode, auto policy, const std::string& query,
+                                       DocumentStatus status, int max_count) {
+        search_server.SetRetrievalMode(retrieval_mode);
+        return search_server.FindTopDocuments(policy, query, status, max_count);
+    };
+
+    for (const auto& query : {"cat"s, "cat dog city"s, "pigeon big cat"s, "nasty -cat"s, "white curly -john dog"s,
+                              "big nasty pigeon white curly john hat eyes tail city dog cat"s, "unknown"s}) {
+        for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+            for (const int max_count : {0, 1, 5, 50}) {
+                const auto expected =
+                    find(SearchServer::RetrievalMode::EXHAUSTIVE, std::execution::seq, query, status, max_count);
+                const auto found = find(SearchServer::RetrievalMode::MAX_SCORE, std::execution::seq, query, status,
+                                        max_count);
+                const auto found_parallel =
+                    find(SearchServer::RetrievalMode::MAX_SCORE, std::execution::par, query, status, max_count);
+
+                ASSERT_EQUAL(found.size(), expected.size());
+                ASSERT_EQUAL(found_parallel.size(), expected.size());
+
+                // documents equal in relevance and rating may come in any order
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    ASSERT_EQUAL(found[i].relevance, expected[i].relevance);
+                    ASSERT_EQUAL(found[i].rating, expected[i].rating);
+                    ASSERT_EQUAL(found_parallel[i].relevance, expected[i].relevance);
+                    ASSERT_EQUAL(found_parallel[i].rating, expected[i].rating);
+                }
+            }
+        }
+    }
+}
+
+void TestPreparedQueryMatchesRawQuery() {
+    SearchServer search_server("and"s);
+
+    search_server.AddDocument(1, "white cat and yellow hat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "curly cat curly tail"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(3, "nasty dog with big eyes"s, DocumentStatus::BANNED, {3});
+    search_server.AddDocument(4, "nasty pigeon john"s, DocumentStatus::ACTUAL, {4});
+
+    const auto raw_query = "curly nasty cat -john unknown"s;
+    const auto prepared_query = search_server.PrepareQuery(raw_query);
+
+    ASSERT(prepared_query.HasPlusWords());
+
+    for (int repeat = 0; repeat < 2; ++repeat) {
+        const auto prepared_documents = search_server.FindTopDocuments(prepared_query);
+        const auto raw_documents = search_server.FindTopDocuments(raw_query);
+
+        ASSERT_EQUAL(prepared_documents.size(), raw_documents.size());
+
+        for (size_t i = 0; i < raw_documents.size(); ++i) {
+            ASSERT_EQUAL(prepared_documents[i].id, raw_documents[i].id);
+        }
+    }
+
+    for (const int document_id : search_server) {
+        const auto [prepared_words, prepared_status] = search_server.MatchDocument(prepared_query, document_id);
+        const auto [raw_words, raw_status] = search_server.MatchDocument(raw_query, document_id);
+
+        ASSERT_EQUAL(prepared_words, raw_words);
+        ASSERT_EQUAL(prepared_status, raw_status);
+    }
+
+    const auto [words, status] = search_server.MatchDocument(prepared_query, 2);
+    ASSERT_EQUAL(words, (std::vector<std::string_view>{"cat"sv, "curly"sv}));
+}
+
+void TestBatchMatchDocumentsMatchesSingleMatches() {
+    SearchServer search_server("and"s);
+
+    for (int document_id = 0; document_id < 300; ++document_id) {
+        std::string document = "word"s + std::to_string(document_id % 3) + " and word"s + std::to_string(document_id % 5);
+        if (document_id % 70 == 0) {
+            document += " rare"s;
+        }
+        search_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, {1});
+    }
+
+    const auto prepared_query = search_server.PrepareQuery("word0 rare word4 -word2 missing"s);
+
+    const auto check_table = [&](const MatchedWordsTable& table) {
+        for (size_t row = 0; row < table.GetDocumentCount(); ++row) {
+            const auto [words, status] = search_server.MatchDocument(prepared_query, table.GetDocumentId(row));
+
+            ASSERT_EQUAL(table.GetMatchedWords(row), words);
+            ASSERT_EQUAL(table.GetStatus(row), status);
+        }
+    };
+
+    const auto range_table = search_server.MatchDocuments(prepared_query, 50, 250);
+    ASSERT_EQUAL(range_table.GetDocumentCount(), 200u);
+    ASSERT_EQUAL(range_table.GetWords(), (std::vector<std::string_view>{"rare"sv, "word0"sv, "word4"sv}));
+    check_table(range_table);
+
+    check_table(search_server.MatchDocuments(std::execution::par, prepared_query, 0, 300));
+
+    const auto set_table = search_server.MatchDocuments(std::execution::par, prepared_query, {280, 70, 3, 70});
+    ASSERT_EQUAL(set_table.GetDocumentIds(), (std::vector<int>{3, 70, 280}));
+    check_table(set_table);
+}
+
+void TestAddDocumentsMatchesAddDocument() {
+    const std::vector<std::string> texts = {"white cat and yellow hat"s, "curly cat curly tail"s,
+                                            "nasty dog with big eyes"s,  "nasty pigeon john"s,
+                                            "big white dog"s,            "and and and"s};
+
+    SearchServer one_by_one("and with"s);
+    SearchServer in_batches("and with"s);
+
+    // ids of the second batch go in between ids that are already indexed
+    std::vector<SearchServer::NewDocument> first_batch;
+    std::vector<SearchServer::NewDocument> second_batch;
+
+    for (size_t i = 0; i < texts.size(); ++i) {
+        const int document_id = static_cast<int>(i * 7 % texts.size()) * 2;
+        one_by_one.AddDocument(document_id, texts[i], DocumentStatus::ACTUAL, {static_cast<int>(i)});
+
+        auto& batch = i % 2 == 0 ? first_batch : second_batch;
+        batch.push_back({document_id, texts[i], DocumentStatus::ACTUAL, {static_cast<int>(i)}});
+    }
+
+    in_batches.AddDocuments(first_batch);
+    in_batches.AddDocuments(std::execution::par, second_batch);
+
+    ASSERT_EQUAL(in_batches.GetDocumentCount(), one_by_one.GetDocumentCount());
+
+    for (const int document_id : one_by_one) {
+        ASSERT_EQUAL(in_batches.GetWordFrequencies(document_id), one_by_one.GetWordFrequencies(document_id));
+    }
+
+    for (const auto& query : {"cat dog"s, "nasty -john"s, "curly white hat"s}) {
+        const auto expected = one_by_one.FindTopDocuments(query);
+        const auto found = in_batches.FindTopDocuments(query);
+
+        ASSERT_EQUAL(found.size(), expected.size());
+
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQUAL(found[i].id, expected[i].id);
+            ASSERT_EQUAL(found[i].rating, expected[i].rating);
+        }
+    }
+
+    // a rejected batch adds nothing
+    try {
+        in_batches.AddDocuments({{100, "new cat"s, DocumentStatus::ACTUAL, {1}}, {100, "old cat"s, DocumentStatus::ACTUAL, {1}}});
+        ASSERT_HINT(false, "repeating ids in a batch are not handled"s);
+    } catch (const std::invalid_argument&) {
+    }
+
+    try {
+        in_batches.AddDocuments({{101, "new cat"s, DocumentStatus::ACTUAL, {1}}, {102, "bad\x12 cat"s, DocumentStatus::ACTUAL, {1}}});
+        ASSERT_HINT(false, "special symbols in a batch are not handled"s);
+    } catch (const std::invalid_argument&) {
+    }
+
+    ASSERT_EQUAL(in_batches.GetDocumentCount(), one_by_one.GetDocumentCount());
+}
+
+void TestSnapshotRoundTrip() {
+    SearchServer server("and with"s);
+    server.AddDocument(3, "white cat and yellow hat"s, DocumentStatus::ACTUAL, {1, 2});
+    server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::IRRELEVANT, {-3});
+    server.AddDocument(8, "nasty dog with big eyes"s, DocumentStatus::BANNED, {4, 5, 6});
+    server.AddDocument(5, "big white dog"s, DocumentStatus::ACTUAL, {0});
+    server.RemoveDocument(8);
+
+    std::stringstream snapshot;
+    server.SaveSnapshot(snapshot);
+    const std::string bytes = snapshot.str();
+
+    std::istringstream input(bytes);
+    const SearchServer loaded = SearchServer::LoadSnapshot(input);
+
+    ASSERT_EQUAL(loaded.GetDocumentCount(), server.GetDocumentCount());
+    ASSERT(std::equal(loaded.begin(), loaded.end(), server.begin(), server.end()));
+
+    for (const int document_id : server) {
+        ASSERT_EQUAL(loaded.GetWordFrequencies(document_id), server.GetWordFrequencies(document_id));
+    }
+
+    for (const auto& query : {"cat dog"s, "curly -tail"s, "white and hat"s, "eyes"s}) {
+        for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED}) {
+            const auto expected = server.FindTopDocuments(query, status);
+            const auto found = loaded.FindTopDocuments(query, status);
+
+            AssertSameDocuments(found, expected);
+        }
+    }
+
+    // stop words are part of the snapshot
+    ASSERT(loaded.FindTopDocuments("and"s).empty());
+    ASSERT_EQUAL(std::get<0>(loaded.MatchDocument("curly cat"s, 1)), std::get<0>(server.MatchDocument("curly cat"s, 1)));
+
+    const auto expect_rejected = [](const std::string& corrupted_bytes, const std::string& hint) {
+        std::istringstream corrupted(corrupted_bytes);
+        try {
+            SearchServer::LoadSnapshot(corrupted);
+            ASSERT_HINT(false, hint);
+        } catch (const std::invalid_argument&) {
+        }
+    };
+
+    expect_rejected(bytes.substr(0, bytes.size() - 1), "truncated snapshot is not rejected"s);
+
+    std::string flipped = bytes;
+    flipped[bytes.size() / 2] ^= 0x20;
+    expect_rejected(flipped, "corrupted snapshot is not rejected"s);
+
+    expect_rejected("not a snapshot at all, just some text"s, "garbage is not rejected"s);
+
+    using search_server_snapshot::SectionHeader;
+    using search_server_snapshot::SectionTag;
+
+    // a size field is not trusted beyond the bytes that follow it
+    std::string oversized = bytes;
+    const uint64_t huge_payload_size = uint64_t{1} << 44;
+    const size_t payload_size_offset =
+        sizeof(search_server_snapshot::SnapshotHeader) + offsetof(SectionHeader, payload_size);
+    std::memcpy(oversized.data() + payload_size_offset, &huge_payload_size, sizeof(huge_payload_size));
+    expect_rejected(oversized, "oversized section is not rejected"s);
+
+    // patch(payload) edits a section, which is checksummed again, so only the consistency checks can catch it
+    const auto patch_section = [&bytes](SectionTag tag, auto patch) {
+        std::string patched = bytes;
+
+        for (size_t offset = sizeof(search_server_snapshot::SnapshotHeader); offset < patched.size();) {
+            SectionHeader header{};
+            std::memcpy(&header, patched.data() + offset, sizeof(header));
+            char* const payload = patched.data() + offset + sizeof(header);
+
+            if (header.tag == tag) {
+                patch(payload);
+                header.checksum = search_server_snapshot::ComputeChecksum(payload, header.payload_size);
+                std::memcpy(patched.data() + offset, &header, sizeof(header));
+                break;
+            }
+
+            offset += sizeof(header) + header.payload_size;
+        }
+
+        return patched;
+    };
+
+    // the first array of a payload starts after its count, the next one after the padded elements
+    const auto get_array = [](char* payload, size_t index, size_t element_size) {
+        for (; index > 0; --index) {
+            uint64_t count = 0;
+            std::memcpy(&count, payload, sizeof(count));
+            payload += sizeof(count) + search_server_snapshot::AlignUp(count * element_size);
+        }
+        return payload + sizeof(uint64_t);
+    };
+
+    // postings of the first term, "white", are documents 3 and 5
+    const auto set_first_postings = [&](int first_document_id, int second_document_id) {
+        return patch_section(SectionTag::POSTINGS, [&](char* payload) {
+            int* const document_ids = reinterpret_cast<int*>(get_array(payload, 1, sizeof(uint64_t)));
+            document_ids[0] = first_document_id;
+            document_ids[1] = second_document_id;
+        });
+    };
+
+    {
+        std::istringstream unchanged(set_first_postings(3, 5));
+        ASSERT_EQUAL(SearchServer::LoadSnapshot(unchanged).GetDocumentCount(), server.GetDocumentCount());
+    }
+
+    expect_rejected(set_first_postings(5, 3), "unsorted postings are not rejected"s);
+    expect_rejected(set_first_postings(3, 3), "repeating postings are not rejected"s);
+    expect_rejected(set_first_postings(3, 4), "postings of unknown documents are not rejected"s);
+
+    expect_rejected(patch_section(SectionTag::DOCUMENTS,
+                                  [&](char* payload) {
+                                      // statuses follow ids and ratings, both arrays of int
+                                      int* const statuses = reinterpret_cast<int*>(get_array(payload, 2, sizeof(int)));
+                                      statuses[0] = 7;
+                                  }),
+                    "unknown status is not rejected"s);
+}
+
+void TestMappedSearchServerMatchesSearchServer() {
+    SearchServer server("and with"s);
+    server.AddDocument(3, "white cat and yellow hat"s, DocumentStatus::ACTUAL, {1, 2});
+    server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::IRRELEVANT, {-3});
+    server.AddDocument(8, "nasty dog with big eyes"s, DocumentStatus::BANNED, {4, 5, 6});
+    server.AddDocument(5, "big white dog"s, DocumentStatus::ACTUAL, {0});
+    server.AddDocument(6, "white dog"s, DocumentStatus::ACTUAL, {7});
+    server.RemoveDocument(8);
+
+    const std::string path = (std::filesystem::temp_directory_path() / "test_mapped_search_server.snapshot"s).string();
+
+    {
+        std::ofstream output(path, std::ios::binary);
+        server.SaveSnapshot(output);
+    }
+
+    {
+        const MappedSearchServer mapped(path);
+
+        ASSERT(mapped.VerifyChecksums());
+        ASSERT_EQUAL(mapped.GetDocumentCount(), server.GetDocumentCount());
+        ASSERT(std::equal(mapped.begin(), mapped.end(), server.begin(), server.end()));
+
+        for (const auto& query : {"cat dog"s, "curly -tail"s, "white and hat"s, "eyes"s, "white dog -cat"s}) {
+            for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED}) {
+                const auto expected = server.FindTopDocuments(query, status);
+                const auto found = mapped.FindTopDocuments(query, status);
+
+                ASSERT_EQUAL(found.size(), expected.size());
+
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    ASSERT_EQUAL(found[i].id, expected[i].id);
+                    ASSERT_EQUAL(found[i].rating, expected[i].rating);
+                    ASSERT_EQUAL(found[i].relevance, expected[i].relevance);
+                }
+            }
+
+            for (const int document_id : server) {
+                const auto [found_words, found_status] = mapped.MatchDocument(query, document_id);
+                const auto [expected_words, expected_status] = server.MatchDocument(query, document_id);
+
+                ASSERT_EQUAL(found_words, expected_words);
+                ASSERT(found_status == expected_status);
+            }
+        }
+
+        const auto even_ids = [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; };
+        ASSERT_EQUAL(mapped.FindTopDocuments("white dog"s, even_ids, 1).size(), 1u);
+        ASSERT_EQUAL(mapped.FindTopDocuments("white dog"s, even_ids, 1)[0].id,
+                     server.FindTopDocuments("white dog"s, even_ids, 1)[0].id);
+
+        for (const auto& malformed_query : {"cat --dog"s, "cat -"s, "cat  dog"s, "cat\x01"s}) {
+            try {
+                mapped.FindTopDocuments(malformed_query);
+                ASSERT_HINT(false, "malformed query is not rejected"s);
+            } catch (const std::invalid_argument&) {
+            }
+        }
+
+        try {
+            mapped.MatchDocument("cat"s, 8);
+            ASSERT_HINT(false, "removed document is matched"s);
+        } catch (const std::out_of_range&) {
+        }
+    }
+
+    // damage a posting, the layout still holds so only the checksums tell
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(-8, std::ios::end);
+        file.put('\x7f');
+    }
+
+    ASSERT(!MappedSearchServer(path).VerifyChecksums());
+
+    // ids up to INT_MAX cost no more than dense ones
+    {
+        SearchServer sparse_server;
+        sparse_server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+        sparse_server.AddDocument(1'500'000'000, "cat and bird"s, DocumentStatus::ACTUAL, {2});
+        sparse_server.AddDocument(std::numeric_limits<int>::max(), "bird in the sky"s, DocumentStatus::ACTUAL, {3});
+
+        std::ofstream output(path, std::ios::binary);
+        sparse_server.SaveSnapshot(output);
+    }
+
+    {
+        const MappedSearchServer mapped(path);
+
+        const auto documents = mapped.FindTopDocuments("cat bird"s);
+        ASSERT_EQUAL(documents.size(), 3u);
+        ASSERT_EQUAL(documents[0].id, 1'500'000'000);
+
+        ASSERT_EQUAL(mapped.FindTopDocuments("bird -cat"s).size(), 1u);
+        ASSERT_EQUAL(mapped.FindTopDocuments("bird -cat"s)[0].id, std::numeric_limits<int>::max());
+    }
+
+    std::filesystem::remove(path);
+
+    try {
+        MappedSearchServer missing(path);
+        ASSERT_HINT(false, "missing snapshot is opened"s);
+    } catch (const std::invalid_argument&) {
+    }
+}
+
+void TestSegmentedSearchServerMatchesSearchServer() {
+    const std::vector<std::string> words = {"white"s, "cat"s, "yellow"s, "hat"s, "curly"s, "tail"s, "nasty"s,
+                                            "dog"s,   "big"s, "eyes"s,   "john"s, "and"s,   "with"s};
+
+    SearchServer server("and with"s);
+    // tiny segments, so the documents spread over many segments and merges
+    SegmentedSearchServer segmented("and with"s, 3);
+
+    const auto expect_same_results = [&server, &segmented]() {
+        ASSERT_EQUAL(segmented.GetDocumentCount(), server.GetDocumentCount());
+
+        for (const auto& query : {"cat dog"s, "curly -tail"s, "white and hat"s, "eyes john -nasty"s, "big"s}) {
+            for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+                const auto expected = server.FindTopDocuments(query, status, 10);
+                const auto found = segmented.FindTopDocuments(std::execution::par, query, status, 10);
+
+                AssertSameDocuments(found, expected);
+            }
+        }
+    };
+
+    for (int document_id = 0; document_id < 40; ++document_id) {
+        std::string text;
+        for (int word = 0; word < 4; ++word) {
+            text += (text.empty() ? ""s : " "s) + words[(document_id * 7 + word * word * 3) % words.size()];
+        }
+
+        // distinct ratings keep the order of equally relevant documents fixed
+        const auto status = document_id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        server.AddDocument(document_id, text, status, {document_id});
+        segmented.AddDocument(document_id, text, status, {document_id});
+    }
+
+    ASSERT(segmented.GetSegmentCount() > 1);
+    expect_same_results();
+
+    for (const int document_id : {0, 4, 7, 8, 9, 21, 39, 100}) {
+        server.RemoveDocument(document_id);
+        segmented.RemoveDocument(document_id);
+    }
+    expect_same_results();
+
+    // an id is free to use again once its document is removed
+    server.AddDocument(7, "curly white hat"s, DocumentStatus::ACTUAL, {77});
+    segmented.AddDocument(7, "curly white hat"s, DocumentStatus::ACTUAL, {77});
+    expect_same_results();
+
+    try {
+        segmented.AddDocument(7, "cat"s, DocumentStatus::ACTUAL, {1});
+        ASSERT_HINT(false, "repeating id is not rejected"s);
+    } catch (const std::invalid_argument&) {
+    }
+
+    segmented.Compact();
+    ASSERT_EQUAL(segmented.GetSegmentCount(), 1u);
+    expect_same_results();
+}
+
+void TestSegmentedSearchServerServesQueriesDuringWrites() {
+    constexpr int kWriterCount = 2;
+    constexpr int kDocumentsPerWriter = 300;
+
+    // writer w adds ids w, w + kWriterCount, ... and removes every third of them right away
+    const auto is_removed = [](int document_id) { return document_id / kWriterCount % 3 == 0; };
+
+    SegmentedSearchServer segmented("and with"s, 16);
+    std::atomic<int> finished_writer_count = 0;
+
+    std::vector<std::thread> threads;
+
+    for (int writer = 0; writer < kWriterCount; ++writer) {
+        threads.emplace_back([&, writer]() {
+            for (int index = 0; index < kDocumentsPerWriter; ++index) {
+                const int document_id = index * kWriterCount + writer;
+                segmented.AddDocument(document_id, MakeDocumentText(document_id), DocumentStatus::ACTUAL,
+                                      {document_id});
+
+                if (is_removed(document_id)) {
+                    segmented.RemoveDocument(document_id);
+                }
+            }
+
+            ++finished_writer_count;
+        });
+    }
+
+    std::atomic<bool> is_consistent = true;
+
+    for (int reader = 0; reader < 2; ++reader) {
+        threads.emplace_back([&]() {
+            while (finished_writer_count < kWriterCount) {
+                const auto found = segmented.FindTopDocuments("cat curly -tail"s, DocumentStatus::ACTUAL, 20);
+
+                // every query sees one version: sorted results of distinct documents, each added in full
+                std::set<int> found_ids;
+
+                for (size_t i = 0; i < found.size(); ++i) {
+                    if (found[i].id >= kWriterCount * kDocumentsPerWriter || !found_ids.insert(found[i].id).second ||
+                        found[i].rating != found[i].id || !std::isfinite(found[i].relevance) ||
+                        (i > 0 && found[i].relevance > found[i - 1].relevance + 1e-6)) {
+                        is_consistent = false;
+                    }
+                }
+            }
+        });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT(is_consistent);
+
+    SearchServer server("and with"s);
+    for (int document_id = 0; document_id < kWriterCount * kDocumentsPerWriter; ++document_id) {
+        if (!is_removed(document_id)) {
+            server.AddDocument(document_id, MakeDocumentText(document_id), DocumentStatus::ACTUAL, {document_id});
+        }
+    }
+
+    ASSERT_EQUAL(segmented.GetDocumentCount(), server.GetDocumentCount());
+
+    for (const auto& query : {"cat dog"s, "curly -tail"s, "white hat"s, "eyes john -nasty"s}) {
+        const auto expected = server.FindTopDocuments(query, DocumentStatus::ACTUAL, 10);
+        const auto found = segmented.FindTopDocuments(query, DocumentStatus::ACTUAL, 10);
+
+        AssertSameDocuments(found, expected);
+    }
+}
+
+void TestIntegerCodecRoundTrip() {
+    // every byte length, in every lane of a group
+    const std::vector<uint32_t> values = {0u,          1u, 255u,           256u, 65'535u, 65'536u, 16'777'215u,
+                                          16'777'216u, 7u, 4'294'967'295u, 300u, 70'000u, 5u};
+
+    for (size_t count = 0; count <= values.size(); ++count) {
+        std::vector<uint8_t> encoded;
+        integer_codec::EncodeStreamVByte(values.data(), count, encoded);
+        const size_t encoded_size = encoded.size();
+        encoded.resize(encoded_size + integer_codec::kDecodePadding);
+
+        std::vector<uint32_t> decoded(values.size() + 4);
+        ASSERT(integer_codec::DecodeStreamVByte(encoded.data(), count, decoded.data()) == encoded.data() + encoded_size);
+        ASSERT(std::equal(values.begin(), values.begin() + count, decoded.begin()));
+    }
+
+    std::vector<uint32_t> increasing = {10u,     10u,         11u,            300u,          70'000u,
+                                        70'001u, 20'000'000u, 4'000'000'000u, 4'000'000'001u};
+
+    std::vector<uint8_t> encoded;
+    integer_codec::EncodeDeltas(increasing.data(), increasing.size(), 3, encoded);
+    const size_t encoded_size = encoded.size();
+    encoded.resize(encoded_size + integer_codec::kDecodePadding);
+
+    std::vector<uint32_t> decoded(increasing.size() + 4);
+    ASSERT(integer_codec::DecodeDeltas(encoded.data(), increasing.size(), 3, decoded.data()) ==
+           encoded.data() + encoded_size);
+    ASSERT(std::equal(increasing.begin(), increasing.end(), decoded.begin()));
+
+    // small gaps take a byte each, plus a control byte per four
+    std::vector<uint32_t> dense(64);
+    std::iota(dense.begin(), dense.end(), 1'000'000u);
+    encoded.clear();
+    integer_codec::EncodeDeltas(dense.data(), dense.size(), 999'999u, encoded);
+    ASSERT_EQUAL(encoded.size(), 64u + 16u);
+}
+
+void TestCompressedSearchServerMatchesSearchServer() {
+    SearchServer server("and"s);
+
+    // word i is about twice as common as word i + 1, so lists span from one posting to many blocks
+    const std::vector<std::string> words = {"cat"s,  "dog"s,   "city"s,  "tail"s,   "eyes"s,  "hat"s,
+                                            "john"s, "curly"s, "white"s, "pigeon"s, "nasty"s, "big"s};
+
+    const auto make_text = [&words](int document_id) {
+        std::string text = "and"s;
+        unsigned int bits = static_cast<unsigned int>(document_id) * 2654435761u;
+
+        for (int i = 0; i < 5; ++i, bits = bits * 1103515245u + 12345u) {
+            size_t word = 0;
+            while (word + 1 < words.size() && (bits >> (8 + word)) % 2 == 1) {
+                ++word;
+            }
+            text += " "s + words[word];
+        }
+
+        return text;
+    };
+
+    for (int document_id = 0; document_id < 3'000; ++document_id) {
+        const auto status = document_id % 9 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        server.AddDocument(document_id, make_text(document_id), status, {document_id % 17});
+    }
+
+    // sparse ids need gaps of several bytes
+    for (int document_id = 100'000; document_id < 20'000'000; document_id += 654'321) {
+        server.AddDocument(document_id, make_text(document_id), DocumentStatus::ACTUAL, {document_id % 13});
+    }
+
+    for (int document_id = 0; document_id < 3'000; document_id += 7) {
+        server.RemoveDocument(document_id);
+    }
+
+    const CompressedSearchServer compressed(server);
+
+    ASSERT_EQUAL(compressed.GetDocumentCount(), server.GetDocumentCount());
+    ASSERT(std::equal(compressed.begin(), compressed.end(), server.begin(), server.end()));
+    ASSERT(compressed.GetPostingMemoryUsage() * 2 < compressed.GetPostingCount() * (sizeof(int) + sizeof(double)));
+
+    for (const auto& query : {"cat"s, "cat dog city"s, "pigeon big cat"s, "nasty -cat"s, "white curly -john dog"s,
+                              "big nasty pigeon white curly john hat eyes tail city dog cat"s, "and unknown"s}) {
+        for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+            for (const int max_count : {0, 1, 5, 50}) {
+                const auto expected = server.FindTopDocuments(query, status, max_count);
+                const auto found = compressed.FindTopDocuments(query, status, max_count);
+
+                ASSERT_EQUAL(found.size(), expected.size());
+
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    ASSERT_EQUAL(found[i].id, expected[i].id);
+                    ASSERT_EQUAL(found[i].rating, expected[i].rating);
+                    ASSERT_EQUAL(found[i].relevance, expected[i].relevance);
+                }
+            }
+        }
+
+        for (const int document_id : {1, 2, 64, 65, 1'000, 2'999, 100'000, 19'729'630}) {
+            ASSERT_EQUAL(std::get<0>(compressed.MatchDocument(query, document_id)),
+                         std::get<0>(server.MatchDocument(query, document_id)));
+        }
+    }
+
+    try {
+        compressed.FindTopDocuments("cat --dog"s);
+        ASSERT_HINT(false, "malformed query is not rejected"s);
+    } catch (const std::invalid_argument&) {
+    }
+
+    try {
+        compressed.MatchDocument("cat"s, 7);
+        ASSERT_HINT(false, "removed document is matched"s);
+    } catch (const std::out_of_range&) {
+    }
+}
+
+void TestScoreAccumulatorResetsBetweenQueries() {
+    score_accumulation::ScoreAccumulator accumulator;
+
+    const auto collect = [&accumulator]() {
+        std::map<int, double> scores;
+        accumulator.ForEach([&scores](int document_id, double relevance) { scores[document_id] = relevance; });
+        return scores;
+    };
+
+    accumulator.Reset(0, 4, 2);
+    accumulator.Add(1, 0.5);
+    accumulator.Add(3, 0.25);
+    accumulator.Add(1, 0.5);
+    accumulator.Exclude(3);
+
+    ASSERT_EQUAL(collect(), (std::map<int, double>{{1, 1.0}}));
+
+    accumulator.Reset(2, 8, 2);
+    accumulator.Add(3, 0.25);
+    accumulator.Add(7, 0.5);
+
+    ASSERT_EQUAL(collect(), (std::map<int, double>{{3, 0.25}, {7, 0.5}}));
+
+    // a range far wider than its documents is not allocated densely
+    accumulator.Reset(0, 2'000'000'000, 3);
+    accumulator.Exclude(1'999'999'999);
+    accumulator.Add(5, 0.25);
+    accumulator.Add(1'999'999'999, 0.5);
+    accumulator.Add(5, 0.25);
+
+    ASSERT_EQUAL(collect(), (std::map<int, double>{{5, 0.5}}));
+
+    accumulator.Reset(0, 2'000'000'000, 3);
+    accumulator.Add(1'999'999'999, 0.5);
+
+    ASSERT_EQUAL(collect(), (std::map<int, double>{{1'999'999'999, 0.5}}));
+
+    accumulator.Reset(2, 8, 2);
+    accumulator.Add(7, 0.5);
+
+    ASSERT_EQUAL(collect(), (std::map<int, double>{{7, 0.5}}));
+}
+
+void TestSparseDocumentIdsAreScored() {
+    SearchServer search_server;
+    search_server.SetParallelScoringShardCount(4);
+
+    search_server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(1'500'000'000, "cat and bird"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(1'500'000'001, "bird in the sky"s, DocumentStatus::ACTUAL, {3});
+
+    for (const auto mode : {SearchServer::RetrievalMode::EXHAUSTIVE, SearchServer::RetrievalMode::MAX_SCORE}) {
+        search_server.SetRetrievalMode(mode);
+
+        for (const auto& documents :
+             {search_server.FindTopDocuments("cat bird"s),
+              search_server.FindTopDocuments(std::execution::par, "cat bird"s, DocumentStatus::ACTUAL)}) {
+            ASSERT_EQUAL(documents.size(), 3u);
+            ASSERT_EQUAL(documents[0].id, 1'500'000'000);
+        }
+
+        const auto documents = search_server.FindTopDocuments("bird -city"s);
+        ASSERT_EQUAL(documents.size(), 2u);
+    }
+}
+
+void TestLargestDocumentIdIsFound() {
+    constexpr int kLargestId = std::numeric_limits<int>::max();
+
+    SearchServer search_server;
+    search_server.SetParallelScoringShardCount(4);
+
+    search_server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(kLargestId, "cat and bird"s, DocumentStatus::ACTUAL, {2});
+
+    for (const auto mode : {SearchServer::RetrievalMode::MAX_SCORE, SearchServer::RetrievalMode::EXHAUSTIVE}) {
+        search_server.SetRetrievalMode(mode);
+
+        for (const auto& documents :
+             {search_server.FindTopDocuments("cat bird"s),
+              search_server.FindTopDocuments(std::execution::par, "cat bird"s, DocumentStatus::ACTUAL)}) {
+            ASSERT_EQUAL(documents.size(), 2u);
+            ASSERT_EQUAL(documents[0].id, kLargestId);
+        }
+
+        ASSERT(search_server.FindTopDocuments("bird -cat"s).empty());
+    }
+
+    const CompressedSearchServer compressed(search_server);
+    ASSERT_EQUAL(compressed.FindTopDocuments("cat bird"s).size(), 2u);
+    ASSERT_EQUAL(compressed.FindTopDocuments("cat bird"s)[0].id, kLargestId);
+    ASSERT(compressed.FindTopDocuments("bird -cat"s).empty());
+
+    SegmentedSearchServer segmented(""s, 1);
+    segmented.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    segmented.AddDocument(kLargestId, "cat and bird"s, DocumentStatus::ACTUAL, {2});
+
+    ASSERT_EQUAL(segmented.FindTopDocuments("cat bird"s).size(), 2u);
+    ASSERT_EQUAL(segmented.FindTopDocuments(std::execution::par, "cat bird"s, DocumentStatus::ACTUAL).size(), 2u);
+}
+
+void TestDocumentBitmapKeepsSparseIds() {
+    search_server_storage_container::DocumentBitmap bitmap;
+
+    const std::vector<int> document_ids = {0, 63, 64, 1'000, std::numeric_limits<int>::max() - 1, 1'500'000'000};
+    for (const int document_id : document_ids) {
+        bitmap.Insert(document_id);
+    }
+
+    // dense ids added after sparse ones may grow the bits over them
+    for (int document_id = 2'000; document_id < 200'000; document_id += 3) {
+        bitmap.Insert(document_id);
+    }
+
+    for (const int document_id : document_ids) {
+        ASSERT(bitmap.Contains(document_id));
+    }
+
+    ASSERT(bitmap.Contains(2'003));
+    ASSERT(!bitmap.Contains(2'004));
+    ASSERT(!bitmap.Contains(1'499'999'999));
+    ASSERT(!bitmap.Contains(std::numeric_limits<int>::max()));
+
+    bitmap.Clear();
+    ASSERT(!bitmap.Contains(1'500'000'000));
+    ASSERT(!bitmap.Contains(0));
+
+    SearchServer search_server;
+    search_server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(std::numeric_limits<int>::max(), "cat and bird"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(std::numeric_limits<int>::max() - 1, "cat and dog"s, DocumentStatus::ACTUAL, {3});
+    search_server.RemoveDocument(std::numeric_limits<int>::max());
+
+    const auto documents = search_server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(documents.size(), 2u);
+    ASSERT(std::none_of(documents.begin(), documents.end(),
+                        [](const Document& document) { return document.id == std::numeric_limits<int>::max(); }));
+}
+
 void TestSearchServer() {
     RUN_TEST(TestStopWordsExclusion);
     RUN_TEST(TestAddedDocumentsCanBeFound);
@@ -463,14 +1960,47 @@ void TestSearchServer() {
     RUN_TEST(TestRelevanceCalculation);
     RUN_TEST(TestSearchNonExistentWord);
     RUN_TEST(TestSplitIntoWordsEscapesSpaces);
+    RUN_TEST(TestSplitIntoWordsValidatedMatchesSplitIntoWords);
     RUN_TEST(TestAddDocumentWithRepeatingId);
     RUN_TEST(TestAddDocumentWithNegativeId);
     RUN_TEST(TestAddDocumentWithSpecialSymbol);
     RUN_TEST(TestDoubleMinusWord);
     RUN_TEST(TestQueryWithSpecialSymbol);
     RUN_TEST(TestEmptyMinusWord);
+    RUN_TEST(TestMatchDocumentWithInvalidQuery);
+    RUN_TEST(TestConcurrentQueriesReportOwnErrors);
     RUN_TEST(TestIteratingOverSearchServer);
     RUN_TEST(TestGetWordFrequencies);
+    RUN_TEST(TestWordStorageHandsOutDenseIds);
+    RUN_TEST(TestGetTermFrequencies);
+    RUN_TEST(TestInverseDocumentFrequenciesFollowDocumentCount);
+    RUN_TEST(TestStringArenaKeepsStringsInPlace);
     RUN_TEST(TestDeletingDocument);
     RUN_TEST(TestRemoveDuplicates);
+    RUN_TEST(TestRemoveDuplicatesReturnsRemovedIds);
+    RUN_TEST(TestFindNearDuplicatesClustersSimilarDocuments);
+    RUN_TEST(TestProcessQueriesFlattenedMatchesProcessQueries);
+    RUN_TEST(TestConcurrentRequestQueueExpiresByTime);
+    RUN_TEST(TestConcurrentRequestQueueCountsConcurrentRequests);
+    RUN_TEST(TestPostingListKeepsDocumentsSorted);
+    RUN_TEST(TestPostingListKeepsBlockBounds);
+    RUN_TEST(TestRemovedDocumentIsNotMatched);
+    RUN_TEST(TestRemovedDocumentsAreCompactedLazily);
+    RUN_TEST(TestResultCacheServesRepeatedQueries);
+    RUN_TEST(TestMaxResultDocumentCount);
+    RUN_TEST(TestScoreAccumulatorResetsBetweenQueries);
+    RUN_TEST(TestSparseDocumentIdsAreScored);
+    RUN_TEST(TestLargestDocumentIdIsFound);
+    RUN_TEST(TestDocumentBitmapKeepsSparseIds);
+    RUN_TEST(TestShardedParallelScoringMatchesSequential);
+    RUN_TEST(TestMaxScoreRetrievalMatchesExhaustive);
+    RUN_TEST(TestPreparedQueryMatchesRawQuery);
+    RUN_TEST(TestBatchMatchDocumentsMatchesSingleMatches);
+    RUN_TEST(TestAddDocumentsMatchesAddDocument);
+    RUN_TEST(TestSnapshotRoundTrip);
+    RUN_TEST(TestMappedSearchServerMatchesSearchServer);
+    RUN_TEST(TestSegmentedSearchServerMatchesSearchServer);
+    RUN_TEST(TestSegmentedSearchServerServesQueriesDuringWrites);
+    RUN_TEST(TestIntegerCodecRoundTrip);
+    RUN_TEST(TestCompressedSearchServerMatchesSearchServer);
 }
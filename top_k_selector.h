@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace top_k_selection {
+
+// Keeps the best `capacity` values pushed so far. The values live in a heap ordered by `is_better`, so its front
+// is the worst kept value and every push costs O(log capacity) instead of sorting all the candidates
+template <typename Value, typename IsBetter>
+class TopKSelector {
+   public:
+    // capacity is only a bound: callers pass the requested result count, which may be far beyond the candidates
+    TopKSelector(size_t capacity, IsBetter is_better) : capacity_(capacity), is_better_(std::move(is_better)) {
+        heap_.reserve(std::min(capacity_, kMaxReservedCapacity));
+    }
+
+   public:
+    void Push(const Value& value) {
+        if (heap_.size() < capacity_) {
+            heap_.push_back(value);
+            std::push_heap(heap_.begin(), heap_.end(), is_better_);
+        } else if (capacity_ > 0 && is_better_(value, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), is_better_);
+            heap_.back() = value;
+            std::push_heap(heap_.begin(), heap_.end(), is_better_);
+        }
+    }
+
+    void Merge(const TopKSelector& other) {
+        for (const Value& value : other.heap_) {
+            Push(value);
+        }
+    }
+
+    bool IsFull() const { return heap_.size() == capacity_; }
+
+    // The value a candidate has to beat to get in, requires a non-empty selector
+    const Value& GetWorst() const { return heap_.front(); }
+
+    size_t Size() const { return heap_.size(); }
+
+    // Best value first
+    std::vector<Value> ExtractSorted() {
+        std::sort_heap(heap_.begin(), heap_.end(), is_better_);
+        return std::move(heap_);
+    }
+
+   private:
+    static constexpr size_t kMaxReservedCapacity = 64;
+
+   private:
+    size_t capacity_;
+    IsBetter is_better_;
+    std::vector<Value> heap_;
+};
+
+}  // namespace top_k_selection
@@ -1,36 +1,63 @@
 #pragma once
 
-#include <list>
-#include <set>
-#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string_view>
-#include <utility>
+#include <unordered_map>
+#include <vector>
+
+#include "string_arena.h"
 
 namespace search_server_storage_container {
 
+// Dense id of a word known to a WordStorage, ids are handed out as 0, 1, 2, ...
+using TermId = uint32_t;
+
+// Dictionary interning every distinct word once. Ids and the views returned by GetWord stay valid for the lifetime
+// of the storage, so the rest of the server can key everything on integer ids
 class WordStorage {
    public:
-    void Insert(std::string word) {
-        if (string_views_.count(word) == 0) {
-            data_.push_back(std::move(word));
-            string_views_.insert(data_.back());
+    // Returns the id of the word, assigning the next free id to a word met for the first time
+    TermId Insert(std::string_view word) {
+        if (const auto it = word_to_term_id_.find(word); it != word_to_term_id_.end()) {
+            return it->second;
         }
+
+        const auto term_id = static_cast<TermId>(words_.size());
+
+        const std::string_view stored_word = data_.Store(word);
+        words_.push_back(stored_word);
+        word_to_term_id_.emplace(stored_word, term_id);
+
+        return term_id;
     }
 
-    void Insert(std::string_view word) {
-        if (string_views_.count(word) == 0) {
-            data_.emplace_back(word);
-            string_views_.insert(data_.back());
+    // Makes room for word_count words, so inserting them does not rehash
+    void Reserve(size_t word_count) {
+        word_to_term_id_.reserve(word_count);
+        words_.reserve(word_count);
+    }
+
+    std::optional<TermId> Find(std::string_view word) const {
+        if (const auto it = word_to_term_id_.find(word); it != word_to_term_id_.end()) {
+            return it->second;
         }
+
+        return std::nullopt;
     }
 
-    std::set<std::string_view>::const_iterator Find(std::string_view word) { return string_views_.find(word); }
+    std::string_view GetWord(TermId term_id) const { return words_[term_id]; }
+
+    size_t Size() const { return words_.size(); }
 
-    auto end() { return string_views_.end(); }
+    // Memory taken by the text of the words
+    const StringArena::MemoryStatistics& GetMemoryStatistics() const { return data_.GetMemoryStatistics(); }
 
    private:
-    std::set<std::string_view> string_views_;
-    std::list<std::string> data_;
+    std::unordered_map<std::string_view, TermId> word_to_term_id_;
+    std::vector<std::string_view> words_;
+    StringArena data_;
 };
 
-}  // namespace search_server_storage_container
\ No newline at end of file
+}  // namespace search_server_storage_container